@@ -13,10 +13,26 @@ LOCAL_SRC_FILES := \
     stb_vorbis.hpp \
     audio.cpp \
     audio.hpp \
+    audio_cache.cpp \
+    audio_cache.hpp \
+    audio_kernel.cpp \
+    audio_kernel.hpp \
+    mixer.cpp \
+    mixer.hpp \
+    profiler.cpp \
+    profiler.hpp \
+    resampler.cpp \
+    resampler.hpp \
     font.cpp \
     font.hpp \
+    frame_bench.cpp \
+    frame_bench.hpp \
+    game.cpp \
+    game.hpp \
     gl_helper.cpp \
     gl_helper.hpp \
+    gpu_timer.cpp \
+    gpu_timer.hpp \
     log.hpp \
 	color_palette.hpp
  
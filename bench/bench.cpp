@@ -0,0 +1,301 @@
+// Microbenchmarks for the CPU side hot paths, nothing here needs a GL context or an audio device.
+// Each case repeats until MIN_TIME_SEC has passed and reports the time per call and item throughput.
+//
+//   number_sequence_game_bench [assets dir] [filter]
+//
+// number_sequence_game_bench_scalar is the same build with the audio kernel and stb_vorbis SIMD turned off.
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "audio_kernel.hpp"
+#include "font.hpp"
+#include "game.hpp"
+#include "geometry.hpp"
+#include "resampler.hpp"
+#include "stb_vorbis.hpp"
+
+namespace {
+constexpr double MIN_TIME_SEC = 0.25;
+
+const char *filter = nullptr;
+
+// Stop the compiler from dropping work whose result is unused
+template <typename T>
+void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// fn is called repeatedly, items is the work done per call (samples, vertices, glyphs ...)
+template <typename F>
+void run(const std::string &name, size_t items, F &&fn) {
+    if (filter && name.find(filter) == std::string::npos) {
+        return;
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    fn();  // warm up caches and lazy allocations
+
+    uint64_t iters = 1;
+    double sec = 0;
+
+    while (true) {
+        auto start = clock::now();
+        for (uint64_t i = 0; i < iters; i++) {
+            fn();
+        }
+        sec = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (sec >= MIN_TIME_SEC) {
+            break;
+        }
+
+        // aim a little past the target so the next round is usually the last
+        double scale = sec > 0 ? MIN_TIME_SEC * 1.2 / sec : 100.0;
+        iters = static_cast<uint64_t>(static_cast<double>(iters) * std::min(scale, 100.0)) + 1;
+    }
+
+    double ns = sec * 1e9 / static_cast<double>(iters);
+    double rate = static_cast<double>(items) / ns * 1e3;  // million items per second
+
+    printf("%-44s %12.1f ns %12.2f M/s\n", name.c_str(), ns, rate);
+}
+
+std::string sized(const char *name, size_t n) { return std::string(name) + "/" + std::to_string(n); }
+
+void bench_geometry() {
+    for (int sides : {8, 64, 512}) {
+        const size_t n = static_cast<size_t>(sides);
+        std::vector<float> radius{0.1f, 0.12f};
+        std::vector<glm::vec2> poly = make_polygon(sides, radius);
+
+        run(sized("make_polygon", n), n, [&] { keep(make_polygon(sides, radius)); });
+        run(sized("make_fill", n), n, [&] { keep(make_fill(poly)); });
+        run(sized("make_line", n), n, [&] { keep(make_line(poly, 0.005f)); });
+    }
+}
+
+void bench_hit_test() {
+    std::array<glm::vec2, 10> center;
+    for (size_t i = 0; i < center.size(); i++) {
+        center[i] = {0.1f + 0.14f * static_cast<float>(i % 5), 0.3f + 0.14f * static_cast<float>(i / 5)};
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> x(0.f, 1.f);
+    std::uniform_real_distribution<float> y(0.f, 9.f / 16.f);
+
+    std::vector<glm::vec2> pos(1024);
+    for (auto &p : pos) {
+        p = {x(rng), y(rng)};
+    }
+
+    run(sized("hit_test", pos.size()), pos.size(), [&] {
+        int hits = 0;
+        for (const auto &p : pos) {
+            hits += hit_test(center, 0.06f, p) >= 0;
+        }
+        keep(hits);
+    });
+}
+
+// Whole rounds played at a fixed step, a press lands on the next digit every few steps
+void bench_game_update() {
+    constexpr float dt = 1.f / 120.f;
+    constexpr size_t steps = 1024;
+
+    Game game(1);
+    size_t press_step = 0;
+
+    run(sized("game_update", steps), steps, [&] {
+        for (size_t i = 0; i < steps; i++) {
+            GameInput input;
+            if (++press_step % 8 == 0 && game.delay_left <= 0) {
+                auto next = std::find(game.number_done.begin(), game.number_done.end(), false);
+                int digit = game.number_sequence[static_cast<size_t>(next - game.number_done.begin()) % SEQ_LEN];
+                input = {true, game.button_center[static_cast<size_t>((digit + 9) % 10)]};  // button i is (i + 1) % 10
+            }
+            keep(game.update(input, dt));
+        }
+    });
+}
+
+void bench_font(const std::string &assets) {
+    size_t size = 0;
+    char *data = static_cast<char *>(SDL_LoadFile((assets + "atlas.txt").c_str(), &size));
+    if (!data) {
+        printf("skipping font, can't open %satlas.txt\n", assets.c_str());
+        return;
+    }
+
+    std::string txt(data, size);
+    SDL_free(data);
+
+    // glyph parsing only reads the texture size, no GL needed
+    FontAtlas font;
+    font.tex = TexturePtr(new Texture{0, 512, 512}, [](Texture *t) { delete t; });
+    if (!font.parse_text(txt)) {
+        printf("skipping font, bad atlas.txt\n");
+        return;
+    }
+
+    std::vector<glm::vec4> vertex_uv;
+    std::vector<uint32_t> index;
+
+    for (size_t n : {4, 32, 256}) {
+        std::string str;
+        for (size_t i = 0; i < n; i++) {
+            str += static_cast<char>('0' + i % 10);
+        }
+
+        run(sized("make_text_vertex", n), n, [&] {
+            font.make_text_vertex(str, true, vertex_uv, index);
+            keep(vertex_uv);
+        });
+    }
+}
+
+void bench_audio_kernels() {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> s16(-32768, 32767);
+
+    for (size_t n : {256, 4096, 65536}) {
+        std::vector<int16_t> src(n);
+        for (auto &s : src) {
+            s = static_cast<int16_t>(s16(rng));
+        }
+
+        std::vector<float> src_f32(n, 0.0f);
+        mix_s16(src_f32.data(), src.data(), n, 1.0f);
+
+        std::vector<float> acc(n * 2, 0.0f);
+        std::vector<int16_t> dst(n, 0);
+
+        run(sized("gain_s16", n), n, [&] { gain_s16(dst.data(), n, 0.5f); });
+        run(sized("mix_s16", n), n, [&] { mix_s16(acc.data(), src.data(), n, 0.5f); });
+        run(sized("mix_f32", n), n, [&] { mix_f32(acc.data(), src_f32.data(), n, 0.5f); });
+        run(sized("mix_s16_mono_to_stereo", n), n, [&] { mix_s16_mono_to_stereo(acc.data(), src.data(), n, 0.5f); });
+        run(sized("saturate_f32", n), n, [&] { saturate_f32(acc.data(), n); });
+        run(sized("saturate_f32_to_s16", n), n, [&] { saturate_f32_to_s16(dst.data(), acc.data(), n); });
+
+        // SDL's mixer for reference, same sample counts
+        auto *dst_bytes = reinterpret_cast<Uint8 *>(dst.data());
+        auto *acc_bytes = reinterpret_cast<Uint8 *>(acc.data());
+        auto *src_bytes = reinterpret_cast<const Uint8 *>(src.data());
+        auto *src_f32_bytes = reinterpret_cast<const Uint8 *>(src_f32.data());
+        const auto s16_len = static_cast<Uint32>(n * sizeof(int16_t));
+        const auto f32_len = static_cast<Uint32>(n * sizeof(float));
+
+        run(sized("SDL_MixAudio_s16", n), n, [&] { SDL_MixAudio(dst_bytes, src_bytes, SDL_AUDIO_S16, s16_len, 0.5f); });
+        run(sized("SDL_MixAudio_f32", n), n, [&] {
+            SDL_MixAudio(acc_bytes, src_f32_bytes, SDL_AUDIO_F32, f32_len, 0.5f);
+        });
+    }
+}
+
+void bench_resampler() {
+    for (int channels : {1, 2}) {
+        const size_t frames = 44100;
+        std::vector<float> src(frames * static_cast<size_t>(channels));
+        for (size_t i = 0; i < src.size(); i++) {
+            src[i] = std::sin(static_cast<float>(i) * 0.05f);
+        }
+
+        run(sized("resample_44100_to_48000_ch", static_cast<size_t>(channels)), frames, [&] {
+            keep(resample(src.data(), frames, channels, 44100, 48000));
+        });
+    }
+}
+
+void bench_vorbis(const std::string &assets) {
+    for (const char *file : {"switch30.ogg", "win.ogg", "bgm.ogg"}) {
+        size_t size = 0;
+        auto *data = static_cast<uint8 *>(SDL_LoadFile((assets + file).c_str(), &size));
+        if (!data) {
+            printf("skipping %s, can't open it\n", file);
+            continue;
+        }
+
+        int error = 0;
+        stb_vorbis *v = stb_vorbis_open_memory(data, static_cast<int>(size), &error, nullptr);
+        if (!v) {
+            printf("skipping %s, not an Ogg Vorbis file (git lfs pull?)\n", file);
+            SDL_free(data);
+            continue;
+        }
+
+        const stb_vorbis_info info = stb_vorbis_get_info(v);
+        const size_t frames = stb_vorbis_stream_length_in_samples(v);
+        const int ch = info.channels;
+        stb_vorbis_close(v);
+
+        const int chunk = 4096 * ch;  // samples per get_samples call
+        std::vector<short> s16(static_cast<size_t>(chunk));
+        std::vector<float> f32(static_cast<size_t>(chunk));
+        std::vector<float> acc(4096 * 2);
+        const std::string name(file);
+
+        // whole file through the one call API, Huffman + IMDCT + interleave
+        run("stb_vorbis_decode_memory/" + name, frames, [&] {
+            int channels, rate;
+            short *out = nullptr;
+            keep(stb_vorbis_decode_memory(data, static_cast<int>(size), &channels, &rate, &out));
+            free(out);
+        });
+
+        // decode then mix, what the mixer sees for an S16 or an F32 clip
+        run("decode_mix_s16/" + name, frames, [&] {
+            stb_vorbis *d = stb_vorbis_open_memory(data, static_cast<int>(size), &error, nullptr);
+            int n;
+            while ((n = stb_vorbis_get_samples_short_interleaved(d, ch, s16.data(), chunk)) > 0) {
+                mix_s16(acc.data(), s16.data(), static_cast<size_t>(n * std::min(ch, 2)), 0.5f);
+            }
+            stb_vorbis_close(d);
+        });
+
+        run("decode_mix_f32/" + name, frames, [&] {
+            stb_vorbis *d = stb_vorbis_open_memory(data, static_cast<int>(size), &error, nullptr);
+            int n;
+            while ((n = stb_vorbis_get_samples_float_interleaved(d, ch, f32.data(), chunk)) > 0) {
+                mix_f32(acc.data(), f32.data(), static_cast<size_t>(n * std::min(ch, 2)), 0.5f);
+            }
+            stb_vorbis_close(d);
+        });
+
+        SDL_free(data);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    std::string assets = argc > 1 ? argv[1] : "assets/";
+    if (!assets.empty() && assets.back() != '/') {
+        assets += '/';
+    }
+
+    filter = argc > 2 ? argv[2] : nullptr;
+
+    printf("%-44s %15s %15s\n", "case", "time/call", "items/sec");
+
+    bench_geometry();
+    bench_hit_test();
+    bench_game_update();
+    bench_font(assets);
+    bench_audio_kernels();
+    bench_resampler();
+    bench_vorbis(assets);
+
+    return 0;
+}
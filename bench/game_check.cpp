@@ -0,0 +1,117 @@
+// Plays the game rules headless through Game::update and hit_test, no SDL or GL.
+//
+//   number_sequence_game_core_check
+
+#include <array>
+#include <cstdio>
+
+#include "game.hpp"
+
+namespace {
+constexpr float DT = 1.f / 120.f;
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// button i is digit (i + 1) % 10
+glm::vec2 button_of(const Game &game, int digit) { return game.button_center[static_cast<size_t>((digit + 9) % 10)]; }
+
+GameEvents press(Game &game, const glm::vec2 &pos) { return game.update({true, pos}, DT); }
+
+void check_hit_test() {
+    std::array<glm::vec2, 3> center{glm::vec2{0.1f, 0.1f}, glm::vec2{0.3f, 0.1f}, glm::vec2{0.5f, 0.5f}};
+
+    check(hit_test(center, 0.05f, {0.1f, 0.1f}) == 0, "hit_test center of first square");
+    check(hit_test(center, 0.05f, {0.34f, 0.13f}) == 1, "hit_test inside second square");
+    check(hit_test(center, 0.05f, {0.5f, 0.54f}) == 2, "hit_test inside third square");
+    check(hit_test(center, 0.05f, {0.2f, 0.1f}) == -1, "hit_test between squares");
+    check(hit_test(center, 0.05f, {0.15f, 0.1f}) == -1, "hit_test edge is outside");
+    check(hit_test({}, 0.05f, {0.1f, 0.1f}) == -1, "hit_test no squares");
+}
+
+void check_round() {
+    Game game(1);
+
+    for (int d : game.number_sequence) {
+        check(d >= 0 && d <= 9, "sequence digits are 0 to 9");
+    }
+
+    check(game.text_x == TEXT_LAYOUT1_X, "first round uses layout 1");
+
+    // every button lands on its own digit
+    for (int d = 0; d < 10; d++) {
+        check(hit_test(game.button_center, BUTTON_RADIUS, button_of(game, d)) == (d + 9) % 10, "button layout");
+    }
+
+    // a press away from every button does nothing
+    GameEvents ev = press(game, {NORM_WIDTH, NORM_HEIGHT});
+    check(!ev.click && !ev.win, "press outside the buttons");
+
+    // a wrong digit clicks but does not advance
+    int wrong = (game.number_sequence[0] + 1) % 10;
+    ev = press(game, button_of(game, wrong));
+    check(ev.click && !game.number_done[0], "wrong digit is not accepted");
+
+    for (size_t i = 0; i < SEQ_LEN; i++) {
+        ev = press(game, button_of(game, game.number_sequence[i]));
+        check(ev.click && game.number_done[i], "right digit is accepted");
+        check(ev.win == (i + 1 == SEQ_LEN), "win only on the last digit");
+    }
+
+    check(game.won() && game.done_count == 1 && game.delay_left > 0, "won round starts the delay");
+
+    // presses are ignored until the next round
+    ev = press(game, button_of(game, game.number_sequence[0]));
+    check(!ev.click, "press during the delay is ignored");
+
+    bool new_round = false;
+    for (int i = 0; i < static_cast<int>(GAME_DELAY_DURATION_SEC / DT) + 2 && !new_round; i++) {
+        new_round = game.update({}, DT).new_round;
+    }
+
+    check(new_round, "next round starts after the delay");
+    check(!game.won() && game.delay_left == 0, "next round is fresh");
+    check(game.text_x == TEXT_LAYOUT2_X, "second round uses layout 2");
+}
+
+// Same seed, same presses, same game
+void check_deterministic() {
+    Game a(7);
+    Game b(7);
+
+    for (int i = 0; i < 1000; i++) {
+        glm::vec2 pos{static_cast<float>(i % 97) / 97.f, static_cast<float>(i % 53) / 53.f * NORM_HEIGHT};
+        GameInput input{i % 5 == 0, pos};
+        GameEvents ea = a.update(input, DT);
+        GameEvents eb = b.update(input, DT);
+
+        if (ea.click != eb.click || ea.win != eb.win || ea.new_round != eb.new_round) {
+            check(false, "same seed and input give the same events");
+            return;
+        }
+    }
+
+    check(a.number_sequence == b.number_sequence && a.done_count == b.done_count, "same seed gives the same state");
+    check(a.bounce_offset == b.bounce_offset, "same seed gives the same bounce");
+}
+}  // namespace
+
+int main() {
+    check_hit_test();
+    check_round();
+    check_deterministic();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Checks the stb_vorbis SIMD IMDCT and window overlap-add against the scalar build.
+// The same fixed inputs go through both builds, the scalar one writes its output and the SIMD one compares.
+//
+//   number_sequence_game_vorbis_check_scalar --write ref.bin
+//   number_sequence_game_vorbis_check --compare ref.bin
+//
+// On x86-64 the two are bit-exact. Other targets may contract the scalar code into FMAs, so a small
+// error relative to the block's peak is accepted there.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "stb_vorbis.hpp"
+
+namespace {
+constexpr int MIN_BLOCK = 64;
+constexpr int MAX_BLOCK = 8192;
+constexpr float MAX_REL_ERROR = 2e-6f;
+
+// Deterministic across compilers and standard libraries, unlike std::uniform_real_distribution
+float next_sample(uint32_t &state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / static_cast<float>(1u << 23) - 1.f;
+}
+
+// Every block size back to back
+bool run_all(std::vector<float> &out) {
+    uint32_t state = 1;
+
+    for (int n = MIN_BLOCK; n <= MAX_BLOCK; n *= 2) {
+        const size_t n2 = static_cast<size_t>(n / 2);
+        std::vector<float> spectrum(n2);
+        std::vector<float> previous(n2);
+
+        for (size_t i = 0; i < n2; i++) {
+            spectrum[i] = next_sample(state);
+            previous[i] = next_sample(state);
+        }
+
+        size_t offset = out.size();
+        out.resize(offset + static_cast<size_t>(n));
+
+        if (!stb_vorbis_test_imdct_overlap(n, spectrum.data(), previous.data(), out.data() + offset)) {
+            printf("block %d: out of memory\n", n);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool write_file(const char *path, const std::vector<float> &data) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        printf("can't open %s\n", path);
+        return false;
+    }
+
+    bool ok = fwrite(data.data(), sizeof(float), data.size(), fp) == data.size();
+    fclose(fp);
+
+    return ok;
+}
+
+bool read_file(const char *path, std::vector<float> &data) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        printf("can't open %s\n", path);
+        return false;
+    }
+
+    bool ok = fread(data.data(), sizeof(float), data.size(), fp) == data.size();
+    fclose(fp);
+
+    return ok;
+}
+
+bool compare(const std::vector<float> &ref, const std::vector<float> &out) {
+    bool ok = true;
+    size_t offset = 0;
+
+    for (int n = MIN_BLOCK; n <= MAX_BLOCK; n *= 2) {
+        const float *r = ref.data() + offset;
+        const float *o = out.data() + offset;
+        offset += static_cast<size_t>(n);
+
+        float peak = 0;
+        float max_error = 0;
+
+        for (int i = 0; i < n; i++) {
+            peak = std::max(peak, std::fabs(r[i]));
+            max_error = std::max(max_error, std::fabs(r[i] - o[i]));
+        }
+
+        bool exact = memcmp(r, o, sizeof(float) * static_cast<size_t>(n)) == 0;
+        bool pass = max_error <= peak * MAX_REL_ERROR;
+        const char *result = exact ? "bit-exact" : pass ? "ok" : "FAIL";
+
+        printf("block %-5d %-10s max error %g (peak %g)\n", n, result, max_error, peak);
+
+        ok = ok && pass;
+    }
+
+    return ok;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 || (strcmp(argv[1], "--write") != 0 && strcmp(argv[1], "--compare") != 0)) {
+        printf("usage: %s --write|--compare file\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<float> out;
+    if (!run_all(out)) {
+        return 1;
+    }
+
+    if (strcmp(argv[1], "--write") == 0) {
+        return write_file(argv[2], out) ? 0 : 1;
+    }
+
+    std::vector<float> ref(out.size());
+    if (!read_file(argv[2], ref)) {
+        return 1;
+    }
+
+    return compare(ref, out) ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+
+"""
+Pack atlas.txt (from font_json_to_txt.py) and atlas.bmp into a single binary file that
+FontAtlas::load_binary reads without any text parsing.
+The output path is the third argument. CMake writes it to assets/ in the build tree, Dockerfile.android into the APK assets.
+
+Example:
+```
+./font_atlas_to_bin.py assets/atlas.txt assets/atlas.bmp assets/atlas.bin
+```
+
+Layout, little endian, no padding. Keep in sync with AtlasHeader/AtlasGlyph in src/font.cpp.
+```
+header (48 bytes)
+    char magic[4] "NSGA"
+    u32 version
+    i32 distance_range
+    f32 em_size
+    i32 grid_width
+    i32 grid_height
+    i32 tex_width
+    i32 tex_height
+    u32 tex_format (0 = RGB8)
+    u32 glyph_count
+    u32 texel_bytes
+    u32 reserved
+glyph (40 bytes) x glyph_count
+    i32 unicode
+    f32 advance, plane left/bottom/right/top, atlas left/bottom/right/top
+texel payload
+    RGB8 rows top to bottom, tightly packed
+```
+"""
+
+import struct
+import sys
+
+VERSION = 1
+TEX_RGB8 = 0
+
+
+def read_txt(path):
+    with open(path, "r") as fp:
+        tok = fp.read().split()
+
+    header = {}
+    i = 0
+    for key in ["distance_range", "em_size", "grid_width", "grid_height"]:
+        if tok[i] != key:
+            sys.exit(f"expected {key}, got {tok[i]}")
+        header[key] = tok[i + 1]
+        i += 2
+
+    if tok[i] != "unicode":
+        sys.exit(f"expected unicode, got {tok[i]}")
+    i += 1
+
+    glyphs = []
+    while i + 10 <= len(tok):
+        glyphs.append((int(tok[i]), [float(x) for x in tok[i + 1 : i + 10]]))
+        i += 10
+
+    return header, glyphs
+
+
+def read_bmp(path):
+    with open(path, "rb") as fp:
+        data = fp.read()
+
+    if data[0:2] != b"BM":
+        sys.exit("not a bmp")
+
+    offset = struct.unpack_from("<I", data, 10)[0]
+    width, height = struct.unpack_from("<ii", data, 18)
+    bpp = struct.unpack_from("<H", data, 28)[0]
+    compression = struct.unpack_from("<I", data, 30)[0]
+
+    if bpp != 24 or compression != 0:
+        sys.exit("only uncompressed 24 bit bmp is supported")
+
+    bottom_up = height > 0
+    height = abs(height)
+    pitch = (width * 3 + 3) & ~3
+
+    rgb = bytearray()
+    for y in range(height):
+        row = height - 1 - y if bottom_up else y
+        start = offset + row * pitch
+        bgr = data[start : start + width * 3]
+        for x in range(width):
+            b, g, r = bgr[x * 3 : x * 3 + 3]
+            rgb += bytes((r, g, b))
+
+    return width, height, bytes(rgb)
+
+
+if len(sys.argv) != 4:
+    sys.exit("usage: font_atlas_to_bin.py atlas.txt atlas.bmp atlas.bin")
+
+header, glyphs = read_txt(sys.argv[1])
+width, height, texel = read_bmp(sys.argv[2])
+
+with open(sys.argv[3], "wb") as fp:
+    fp.write(
+        struct.pack(
+            "<4sIifiiiiIIII",
+            b"NSGA",
+            VERSION,
+            int(header["distance_range"]),
+            float(header["em_size"]),
+            int(header["grid_width"]),
+            int(header["grid_height"]),
+            width,
+            height,
+            TEX_RGB8,
+            len(glyphs),
+            len(texel),
+            0,
+        )
+    )
+
+    for unicode, v in glyphs:
+        fp.write(struct.pack("<i9f", unicode, *v))
+
+    fp.write(texel)
@@ -2,53 +2,328 @@
 
 #include <SDL3/SDL_audio.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <mutex>
+#include <system_error>
+#include <thread>
 
+#include "audio_cache.hpp"
 #include "log.hpp"
+#include "resampler.hpp"
 #include "stb_vorbis.hpp"
 
-void Audio::play(bool clear_stream) {
+void Music::play() {
     if (stream) {
-        if (clear_stream) {
-            SDL_ClearAudioStream(stream);
+        SDL_ResumeAudioStreamDevice(stream);
+    }
+}
+
+void Music::set_loop(unsigned int start, unsigned int end) {
+    if (stream) {
+        SDL_LockAudioStream(stream);
+        loop_start = start;
+        loop_end = end;
+        SDL_UnlockAudioStream(stream);
+    }
+}
+
+size_t Audio::frames() const {
+    if (spec.channels <= 0) {
+        return 0;
+    }
+
+    size_t samples = pcm ? pcm->size() : pcm_f32 ? pcm_f32->size() : 0;
+    return samples / static_cast<size_t>(spec.channels);
+}
+
+namespace {
+int get_samples(stb_vorbis *v, int channels, short *out, int num) {
+    return stb_vorbis_get_samples_short_interleaved(v, channels, out, num);
+}
+
+int get_samples(stb_vorbis *v, int channels, float *out, int num) {
+    return stb_vorbis_get_samples_float_interleaved(v, channels, out, num);
+}
+
+template <typename T>
+int decode_music(Music &m, T *out, int frames) {
+    int done = 0;
+    bool rewound = false;
+
+    while (done < frames) {
+        int want = frames - done;
+        if (m.loop_end > m.loop_start) {
+            unsigned int left = m.loop_end - std::min(m.pos, m.loop_end);
+            want = std::min(want, static_cast<int>(left));
         }
 
-        SDL_PutAudioStreamData(stream, data.data(), static_cast<int>(data.size()));
-        SDL_ResumeAudioStreamDevice(stream);
+        int n = 0;
+        if (want > 0) {
+            n = get_samples(m.vorbis, m.spec.channels, out + done * m.spec.channels, want * m.spec.channels);
+        }
+
+        if (n == 0) {
+            // a rewind that yields nothing means the file is empty or broken
+            if (rewound) {
+                break;
+            }
+
+            // seek is sample accurate, seek_start skips the page search
+            bool ok = m.loop_start == 0 ? stb_vorbis_seek_start(m.vorbis) : stb_vorbis_seek(m.vorbis, m.loop_start);
+            if (!ok) {
+                break;
+            }
+
+            m.pos = m.loop_start;
+            rewound = true;
+            continue;
+        }
+
+        done += n;
+        m.pos += static_cast<unsigned int>(n);
+        rewound = false;
     }
+
+    return done;
+}
+
+}  // namespace
+
+int Music::decode(void *out, int frames) {
+    if (spec.format == SDL_AUDIO_F32) {
+        return decode_music(*this, static_cast<float *>(out), frames);
+    }
+    return decode_music(*this, static_cast<short *>(out), frames);
 }
 
 namespace {
-std::vector<uint8_t> change_volume(const std::vector<uint8_t> &data, SDL_AudioSpec spec, float volume) {
-    std::vector<uint8_t> ret(data.size());
-    SDL_MixAudio(ret.data(), data.data(), spec.format, static_cast<Uint32>(data.size()), volume);
-    return ret;
+constexpr unsigned int PARALLEL_DECODE_MIN_SEC = 2;  // shortest range worth a thread
+
+// Sound effects decode concurrently, each one only gets the cores the others left free.
+// The calling threads count too, so the total stays near hardware_concurrency.
+std::mutex decode_thread_mutex;
+unsigned int decode_threads_busy = 0;
+
+// Threads reserved for one decode, including the caller. Always at least 1, returned on destruction.
+struct DecodeThreads {
+    unsigned int count;
+
+    explicit DecodeThreads(unsigned int want) {
+        std::lock_guard<std::mutex> lock(decode_thread_mutex);
+
+        unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+        unsigned int idle = cores > decode_threads_busy + 1 ? cores - decode_threads_busy - 1 : 0;
+
+        count = 1 + std::min(want > 0 ? want - 1 : 0, idle);
+        decode_threads_busy += count;
+    }
+
+    ~DecodeThreads() {
+        std::lock_guard<std::mutex> lock(decode_thread_mutex);
+        decode_threads_busy -= count;
+    }
+
+    DecodeThreads(const DecodeThreads &) = delete;
+    DecodeThreads &operator=(const DecodeThreads &) = delete;
+};
+
+void SDLCALL music_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
+    (void)total_amount;
+
+    Music &m = *static_cast<Music *>(userdata);
+    const int frame_bytes = SDL_AUDIO_FRAMESIZE(m.spec);
+    int frames = (additional_amount + frame_bytes - 1) / frame_bytes;
+
+    while (frames > 0) {
+        int n = m.decode(m.chunk.data(), std::min(frames, Music::CHUNK_FRAMES));
+        if (n == 0) {
+            break;
+        }
+
+        SDL_PutAudioStreamData(stream, m.chunk.data(), n * frame_bytes);
+        frames -= n;
+    }
 }
 
-bool load_stream(SDL_AudioDeviceID audio_device, Audio &audio, float volume) {
-    audio.stream = SDL_CreateAudioStream(&audio.spec, NULL);
+// Decode [start, end) into out, returns the number of frames decoded
+template <typename T>
+int decode_range(stb_vorbis *v, int channels, unsigned int start, unsigned int end, T *out) {
+    // seek locates the page by granule position and decodes the frame before
+    // start as pre-roll, so the output matches a sequential decode exactly
+    if (start > 0 && !stb_vorbis_seek(v, start)) {
+        return 0;
+    }
 
-    if (!audio.stream) {
-        LOG("Couldn't create audio stream: %s", SDL_GetError());
-        return false;
+    int done = 0;
+    int want = static_cast<int>(end - start);
+
+    while (done < want) {
+        int n = get_samples(v, channels, out + done * channels, (want - done) * channels);
+        if (n == 0) {
+            break;
+        }
+        done += n;
     }
 
-    if (!SDL_BindAudioStream(audio_device, audio.stream)) {
-        LOG("Failed to bind stream to device: %s", SDL_GetError());
-        return false;
+    return done;
+}
+
+// Split the file into equal sample ranges and decode them on separate threads.
+// Returns nothing if the file is too short to be worth it or a range fails,
+// the caller falls back to a sequential decode.
+template <typename T>
+std::optional<std::vector<T>> decode_parallel(const uint8_t *data, int size, int &channels, int &freq) {
+    int error = 0;
+    stb_vorbis *v = stb_vorbis_open_memory(data, size, &error, nullptr);
+    if (!v) {
+        return {};
+    }
+
+    stb_vorbis_info info = stb_vorbis_get_info(v);
+    unsigned int total = stb_vorbis_stream_length_in_samples(v);
+    unsigned int min_range = info.sample_rate * PARALLEL_DECODE_MIN_SEC;
+
+#ifdef __EMSCRIPTEN__
+    const DecodeThreads reserved(1);  // no pthreads in the wasm build
+#else
+    const DecodeThreads reserved(min_range > 0 ? total / min_range : 0u);
+#endif
+    const unsigned int threads = reserved.count;
+
+    if (threads <= 1) {
+        stb_vorbis_close(v);
+        return {};
+    }
+
+    channels = info.channels;
+    freq = static_cast<int>(info.sample_rate);
+
+    std::vector<T> pcm(static_cast<size_t>(total) * static_cast<size_t>(channels));
+    std::vector<unsigned int> bound(threads + 1);
+    std::vector<int> decoded(threads);
+
+    for (unsigned int i = 0; i <= threads; i++) {
+        bound[i] = static_cast<unsigned int>(static_cast<uint64_t>(total) * i / threads);
+    }
+
+    auto run = [&](unsigned int i, stb_vorbis *d) {
+        T *out = pcm.data() + static_cast<size_t>(bound[i]) * static_cast<size_t>(channels);
+        decoded[i] = decode_range(d, channels, bound[i], bound[i + 1], out);
+        stb_vorbis_close(d);
+    };
+
+    // every range needs its own decoder, the first one reuses v on this thread
+    std::vector<std::thread> worker;
+    worker.reserve(threads - 1);  // emplace_back can then only throw from the thread constructor
+
+    for (unsigned int i = 1; i < threads; i++) {
+        stb_vorbis *d = stb_vorbis_open_memory(data, size, &error, nullptr);
+        if (!d) {
+            decoded[i] = -1;
+            continue;
+        }
+
+        try {
+            worker.emplace_back(run, i, d);
+        } catch (const std::system_error &e) {
+            // out of threads, d was not handed over so decode this range here
+            LOG("Can't start decode thread: %s", e.what());
+            run(i, d);
+        }
+    }
+
+    run(0, v);
+
+    for (auto &w : worker) {
+        w.join();
+    }
+
+    // only the last range may come up short, the length from the last granule can overshoot
+    for (unsigned int i = 0; i + 1 < threads; i++) {
+        if (decoded[i] != static_cast<int>(bound[i + 1] - bound[i])) {
+            return {};
+        }
+    }
+
+    if (decoded[threads - 1] < 0) {
+        return {};
+    }
+
+    pcm.resize(static_cast<size_t>(bound[threads - 1] + static_cast<unsigned int>(decoded[threads - 1])) *
+               static_cast<size_t>(channels));
+
+    return pcm;
+}
+
+template <typename T>
+std::optional<std::vector<T>> decode_sequential(const uint8_t *data, int size, int &channels, int &freq) {
+    int error = 0;
+    stb_vorbis *v = stb_vorbis_open_memory(data, size, &error, nullptr);
+    if (!v) {
+        return {};
+    }
+
+    stb_vorbis_info info = stb_vorbis_get_info(v);
+    channels = info.channels;
+    freq = static_cast<int>(info.sample_rate);
+
+    std::vector<T> pcm;
+    size_t frames = 0;
+
+    while (true) {
+        const size_t offset = frames * static_cast<size_t>(channels);
+        pcm.resize(offset + static_cast<size_t>(Music::CHUNK_FRAMES * channels));
+        int n = get_samples(v, channels, pcm.data() + offset, Music::CHUNK_FRAMES * channels);
+        if (n == 0) {
+            break;
+        }
+        frames += static_cast<size_t>(n);
+    }
+
+    stb_vorbis_close(v);
+    pcm.resize(frames * static_cast<size_t>(channels));
+
+    return pcm;
+}
+
+template <typename T>
+std::optional<std::vector<T>> decode_ogg(const uint8_t *data, int size, int &channels, int &freq) {
+    if (auto pcm = decode_parallel<T>(data, size, channels, freq)) {
+        return pcm;
     }
+    return decode_sequential<T>(data, size, channels, freq);
+}
 
-    if (volume > 0.0f && volume < 1.0f) {
-        audio.data = change_volume(audio.data, audio.spec, volume);
+// Convert to freq once so the mixer never steps through the samples per play
+void resample_to(Audio &audio, int freq) {
+    if (freq <= 0 || freq == audio.spec.freq) {
+        return;
     }
 
-    return true;
+    if (audio.pcm_f32) {
+        audio.pcm_f32 = std::make_shared<const std::vector<float>>(
+            resample(audio.pcm_f32->data(), audio.frames(), audio.spec.channels, audio.spec.freq, freq));
+    } else if (audio.pcm) {
+        audio.pcm = std::make_shared<const std::vector<int16_t>>(
+            resample(audio.pcm->data(), audio.frames(), audio.spec.channels, audio.spec.freq, freq));
+    }
+
+    audio.spec.freq = freq;
 }
 
 }  // namespace
 
-std::optional<Audio> load_ogg(SDL_AudioDeviceID audio_device, const char *path, float volume) {
+SDL_AudioFormat decode_format(SDL_AudioDeviceID audio_device) {
+    SDL_AudioSpec spec{};
+    if (SDL_GetAudioDeviceFormat(audio_device, &spec, nullptr) && SDL_AUDIO_ISFLOAT(spec.format)) {
+        return SDL_AUDIO_F32;
+    }
+    return SDL_AUDIO_S16;
+}
+
+std::optional<Audio> load_ogg(const char *path, float volume, SDL_AudioFormat format, int freq) {
     // NOTE: Can't use fopen on files inside an Android APK.
     // SDL provides IO abstraction for this.
     size_t data_size;
@@ -59,44 +334,150 @@ std::optional<Audio> load_ogg(SDL_AudioDeviceID audio_device, const char *path,
         return {};
     }
 
-    Audio ret;
+    if (format != SDL_AUDIO_F32) {
+        format = SDL_AUDIO_S16;
+    }
 
-    short *output;
-    int samples =
-        stb_vorbis_decode_memory(data, static_cast<int>(data_size), &ret.spec.channels, &ret.spec.freq, &output);
+    const uint64_t cache_key = audio_cache_key(data, data_size, format, freq);
 
-    ret.data.resize(static_cast<size_t>(samples * ret.spec.channels) * sizeof(short));
-    memcpy(ret.data.data(), output, ret.data.size());
+    if (auto cached = audio_cache_load(cache_key)) {
+        SDL_free(data);
+        cached->gain = volume;
+        return cached;
+    }
 
-    free(output);
-    SDL_free(data);
+    Audio ret;
+    ret.gain = volume;
+    bool ok = false;
 
-    ret.spec.format = SDL_AUDIO_S16LE;
+    if (format == SDL_AUDIO_F32) {
+        ret.spec.format = SDL_AUDIO_F32;
+        if (auto pcm = decode_ogg<float>(data, static_cast<int>(data_size), ret.spec.channels, ret.spec.freq)) {
+            ret.pcm_f32 = std::make_shared<const std::vector<float>>(std::move(*pcm));
+            ok = true;
+        }
+    } else {
+        ret.spec.format = SDL_AUDIO_S16;
+        if (auto pcm = decode_ogg<int16_t>(data, static_cast<int>(data_size), ret.spec.channels, ret.spec.freq)) {
+            ret.pcm = std::make_shared<const std::vector<int16_t>>(std::move(*pcm));
+            ok = true;
+        }
+    }
 
-    if (!load_stream(audio_device, ret, volume)) {
+    SDL_free(data);
+
+    if (!ok) {
+        LOG("Failed to decode '%s'.", path);
         return {};
     }
 
+    resample_to(ret, freq);
+    audio_cache_store(cache_key, ret);
+
     return ret;
 }
 
-std::optional<Audio> load_wav(SDL_AudioDeviceID audio_device, const char *path, float volume) {
-    Audio ret;
-
+std::optional<Audio> load_wav(const char *path, float volume, SDL_AudioFormat format, int freq) {
+    SDL_AudioSpec spec;
     uint8_t *data = nullptr;
     uint32_t data_len;
 
-    if (!SDL_LoadWAV(path, &ret.spec, &data, &data_len)) {
+    if (!SDL_LoadWAV(path, &spec, &data, &data_len)) {
         LOG("Failed to open file '%s'.", path);
         return {};
     }
 
-    ret.data.assign(data, data + data_len);
+    Audio ret;
+    ret.spec = spec;
+    ret.spec.format = format == SDL_AUDIO_F32 ? SDL_AUDIO_F32 : SDL_AUDIO_S16;
+    ret.gain = volume;
+
+    uint8_t *out = nullptr;
+    int out_len = 0;
+
+    bool ok = SDL_ConvertAudioSamples(&spec, data, static_cast<int>(data_len), &ret.spec, &out, &out_len);
     SDL_free(data);
 
-    if (!load_stream(audio_device, ret, volume)) {
+    if (!ok) {
+        LOG("Failed to convert '%s': %s", path, SDL_GetError());
         return {};
     }
 
+    const size_t out_bytes = static_cast<size_t>(out_len);
+
+    if (ret.spec.format == SDL_AUDIO_F32) {
+        const float *begin = reinterpret_cast<const float *>(out);
+        ret.pcm_f32 = std::make_shared<const std::vector<float>>(begin, begin + out_bytes / sizeof(float));
+    } else {
+        const int16_t *begin = reinterpret_cast<const int16_t *>(out);
+        ret.pcm = std::make_shared<const std::vector<int16_t>>(begin, begin + out_bytes / sizeof(int16_t));
+    }
+
+    SDL_free(out);
+
+    resample_to(ret, freq);
+
     return ret;
 }
+
+MusicPtr load_music(SDL_AudioDeviceID audio_device, const char *path, float volume, unsigned int loop_start) {
+    auto cleanup = [](Music *m) {
+        if (m->stream) {
+            SDL_SetAudioStreamGetCallback(m->stream, nullptr, nullptr);
+        }
+        if (m->vorbis) {
+            stb_vorbis_close(m->vorbis);
+        }
+        delete m;
+    };
+
+    MusicPtr m(new Music, cleanup);
+
+    size_t data_size;
+    uint8_t *data = static_cast<uint8_t *>(SDL_LoadFile(path, &data_size));
+
+    if (!data) {
+        LOG("Failed to open file '%s'.", path);
+        return {{}, {}};
+    }
+
+    m->ogg.assign(data, data + data_size);
+    SDL_free(data);
+
+    int error = 0;
+    m->vorbis = stb_vorbis_open_memory(m->ogg.data(), static_cast<int>(m->ogg.size()), &error, nullptr);
+
+    if (!m->vorbis) {
+        LOG("Failed to decode '%s', stb_vorbis error %d.", path, error);
+        return {{}, {}};
+    }
+
+    stb_vorbis_info info = stb_vorbis_get_info(m->vorbis);
+    m->spec.format = decode_format(audio_device);
+    m->spec.channels = info.channels;
+    m->spec.freq = static_cast<int>(info.sample_rate);
+    m->chunk.resize(static_cast<size_t>(Music::CHUNK_FRAMES * SDL_AUDIO_FRAMESIZE(m->spec)));
+    m->loop_start = loop_start;
+
+    m->stream = SDL_CreateAudioStream(&m->spec, NULL);
+
+    if (!m->stream) {
+        LOG("Couldn't create audio stream: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    if (!SDL_SetAudioStreamGetCallback(m->stream, music_callback, m.get())) {
+        LOG("Couldn't set music callback: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    if (!SDL_BindAudioStream(audio_device, m->stream)) {
+        LOG("Failed to bind stream to device: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    // applied by SDL while converting, so the decoded chunks stay untouched
+    SDL_SetAudioStreamGain(m->stream, volume);
+
+    return m;
+}
@@ -2,16 +2,57 @@
 
 #include <SDL3/SDL.h>
 
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <vector>
 
+#include "stb_vorbis.hpp"
+
+// Fully decoded sound effect, played through the Mixer.
+// The PCM is immutable so voices can share it, only the vector matching spec.format is set.
 struct Audio {
+    SDL_AudioSpec spec{};  // SDL_AUDIO_S16 or SDL_AUDIO_F32
+    std::shared_ptr<const std::vector<int16_t>> pcm;
+    std::shared_ptr<const std::vector<float>> pcm_f32;
+    float gain = 1.0f;  // applied while mixing
+
+    size_t frames() const;
+};
+
+// Looping background music, decoded a chunk at a time from the compressed file.
+// The stream pulls from the audio thread so exactly what the device needs is queued.
+struct Music {
+    static constexpr int CHUNK_FRAMES = 4096;
+
     SDL_AudioStream *stream = nullptr;
     SDL_AudioSpec spec{};
-    std::vector<uint8_t> data;
+    std::vector<uint8_t> ogg;  // must outlive vorbis
+    stb_vorbis *vorbis = nullptr;
+    std::vector<uint8_t> chunk;  // CHUNK_FRAMES in spec.format, audio thread only
 
-    void play(bool clear_stream);
+    unsigned int pos = 0;         // next frame to decode
+    unsigned int loop_start = 0;  // frame to jump back to
+    unsigned int loop_end = 0;    // frame to jump back from, 0 for end of file
+
+    void play();
+    void set_loop(unsigned int start, unsigned int end);
+
+    // Fill out with frames in spec.format, wrapping to loop_start at loop_end.
+    // Returns the number of frames written, called with the stream locked.
+    int decode(void *out, int frames);
 };
 
-std::optional<Audio> load_ogg(SDL_AudioDeviceID audio_device, const char *path, float volume = 1.0f);
-std::optional<Audio> load_wav(SDL_AudioDeviceID audio_device, const char *path, float volume = 1.0f);
+using MusicPtr = std::unique_ptr<Music, void (*)(Music *)>;
+
+// SDL_AUDIO_F32 when the device mixes in float so decoded audio stays float end to end,
+// SDL_AUDIO_S16 otherwise
+SDL_AudioFormat decode_format(SDL_AudioDeviceID audio_device);
+
+// Safe to call from a worker thread.
+// freq > 0 resamples once at load so playback at that rate is a straight mix.
+std::optional<Audio> load_ogg(
+    const char *path, float volume = 1.0f, SDL_AudioFormat format = SDL_AUDIO_S16, int freq = 0);
+std::optional<Audio> load_wav(
+    const char *path, float volume = 1.0f, SDL_AudioFormat format = SDL_AUDIO_S16, int freq = 0);
+MusicPtr load_music(SDL_AudioDeviceID audio_device, const char *path, float volume = 1.0f, unsigned int loop_start = 0);
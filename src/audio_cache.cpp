@@ -0,0 +1,244 @@
+#include "audio_cache.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "log.hpp"
+
+#ifdef PCM_CACHE
+namespace {
+constexpr char CACHE_MAGIC[4] = {'N', 'S', 'G', 'P'};  // not NSGA, that is the font atlas
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    int32_t channels;
+    int32_t freq;
+    uint32_t reserved;
+    uint64_t samples;
+};
+
+// 64-bit FNV-1a
+uint64_t hash(const void *data, size_t size, uint64_t h = 0xcbf29ce484222325ull) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Empty when there is nowhere writable to keep the cache
+const std::string &cache_dir() {
+    static const std::string dir = [] {
+        char *pref = SDL_GetPrefPath("nghiaho12", "number_sequence_game");
+        if (!pref) {
+            LOG("No audio cache: %s", SDL_GetError());
+            return std::string();
+        }
+
+        std::string d = std::string(pref) + "pcm/";
+        SDL_free(pref);
+
+        if (!SDL_CreateDirectory(d.c_str())) {
+            LOG("No audio cache: %s", SDL_GetError());
+            return std::string();
+        }
+
+        return d;
+    }();
+
+    return dir;
+}
+
+std::string cache_path(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.pcm", static_cast<unsigned long long>(key));
+    return cache_dir() + name;
+}
+
+// Temp files younger than this may belong to another instance still writing
+constexpr SDL_Time TMP_MAX_AGE_NS = 3600 * SDL_NS_PER_SECOND;
+
+// Every key looked up this session, the rest of the directory is stale
+std::mutex used_mutex;
+std::vector<uint64_t> used_keys;
+
+bool ends_with(const std::string &s, const char *suffix) {
+    const size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+}  // namespace
+
+uint64_t audio_cache_key(const void *data, size_t size, SDL_AudioFormat format, int freq) {
+    const uint32_t params[3] = {AUDIO_CACHE_VERSION, static_cast<uint32_t>(format), static_cast<uint32_t>(freq)};
+    return hash(params, sizeof(params), hash(data, size));
+}
+
+std::optional<Audio> audio_cache_load(uint64_t key) {
+    if (cache_dir().empty()) {
+        return {};
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(used_mutex);
+        used_keys.push_back(key);
+    }
+
+    size_t size = 0;
+    std::unique_ptr<uint8_t, void (*)(void *)> file(
+        static_cast<uint8_t *>(SDL_LoadFile(cache_path(key).c_str(), &size)), SDL_free);
+
+    if (!file || size < sizeof(CacheHeader)) {
+        return {};
+    }
+
+    CacheHeader h;
+    std::memcpy(&h, file.get(), sizeof(h));
+
+    const SDL_AudioFormat format = static_cast<SDL_AudioFormat>(h.format);
+    const bool is_f32 = format == SDL_AUDIO_F32;
+
+    if (std::memcmp(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || h.version != AUDIO_CACHE_VERSION ||
+        h.key != key || (!is_f32 && format != SDL_AUDIO_S16) || h.channels <= 0) {
+        LOG("Ignoring stale audio cache entry %016llx", static_cast<unsigned long long>(key));
+        return {};
+    }
+
+    const size_t sample_bytes = is_f32 ? sizeof(float) : sizeof(int16_t);
+    if (size - sizeof(CacheHeader) != h.samples * sample_bytes) {
+        LOG("Ignoring truncated audio cache entry %016llx", static_cast<unsigned long long>(key));
+        return {};
+    }
+
+    Audio ret;
+    ret.spec.format = format;
+    ret.spec.channels = h.channels;
+    ret.spec.freq = h.freq;
+
+    const uint8_t *pcm = file.get() + sizeof(CacheHeader);
+
+    if (is_f32) {
+        std::vector<float> v(static_cast<size_t>(h.samples));
+        std::memcpy(v.data(), pcm, v.size() * sizeof(float));
+        ret.pcm_f32 = std::make_shared<const std::vector<float>>(std::move(v));
+    } else {
+        std::vector<int16_t> v(static_cast<size_t>(h.samples));
+        std::memcpy(v.data(), pcm, v.size() * sizeof(int16_t));
+        ret.pcm = std::make_shared<const std::vector<int16_t>>(std::move(v));
+    }
+
+    return ret;
+}
+
+void audio_cache_store(uint64_t key, const Audio &audio) {
+    if (cache_dir().empty()) {
+        return;
+    }
+
+    const void *pcm = nullptr;
+    size_t samples = 0;
+    size_t sample_bytes = 0;
+
+    if (audio.pcm_f32) {
+        pcm = audio.pcm_f32->data();
+        samples = audio.pcm_f32->size();
+        sample_bytes = sizeof(float);
+    } else if (audio.pcm) {
+        pcm = audio.pcm->data();
+        samples = audio.pcm->size();
+        sample_bytes = sizeof(int16_t);
+    } else {
+        return;
+    }
+
+    CacheHeader h{};
+    std::memcpy(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    h.version = AUDIO_CACHE_VERSION;
+    h.key = key;
+    h.format = static_cast<uint32_t>(audio.spec.format);
+    h.channels = audio.spec.channels;
+    h.freq = audio.spec.freq;
+    h.samples = samples;
+
+    std::vector<uint8_t> file(sizeof(h) + samples * sample_bytes);
+    std::memcpy(file.data(), &h, sizeof(h));
+    std::memcpy(file.data() + sizeof(h), pcm, samples * sample_bytes);
+
+    // write then rename so a crash or a second instance never sees half a file,
+    // the temp name is unique so two writers never share one
+    const std::string path = cache_path(key);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%08x.tmp", static_cast<unsigned int>(std::random_device{}()));
+    const std::string tmp = path + suffix;
+
+    if (!SDL_SaveFile(tmp.c_str(), file.data(), file.size()) || !SDL_RenamePath(tmp.c_str(), path.c_str())) {
+        LOG("Failed to write audio cache '%s': %s", path.c_str(), SDL_GetError());
+        SDL_RemovePath(tmp.c_str());
+    }
+}
+
+void audio_cache_prune() {
+    if (cache_dir().empty()) {
+        return;
+    }
+
+    std::vector<uint64_t> keep;
+    {
+        std::lock_guard<std::mutex> lock(used_mutex);
+        keep = used_keys;
+    }
+
+    int count = 0;
+    std::unique_ptr<char *, void (*)(void *)> files(SDL_GlobDirectory(cache_dir().c_str(), nullptr, 0, &count),
+                                                    SDL_free);
+    if (!files) {
+        return;
+    }
+
+    SDL_Time now = 0;
+    SDL_GetCurrentTime(&now);
+
+    int removed = 0;
+
+    for (int i = 0; i < count; i++) {
+        const std::string name = files.get()[i];
+        const std::string path = cache_dir() + name;
+        bool stale = false;
+
+        if (ends_with(name, ".pcm")) {
+            // entries from older assets, formats, rates or AUDIO_CACHE_VERSION
+            uint64_t key = std::strtoull(name.c_str(), nullptr, 16);
+            stale = std::find(keep.begin(), keep.end(), key) == keep.end();
+        } else if (ends_with(name, ".tmp")) {
+            // left behind by a crash mid write
+            SDL_PathInfo info;
+            stale = SDL_GetPathInfo(path.c_str(), &info) && now - info.modify_time > TMP_MAX_AGE_NS;
+        }
+
+        if (stale && SDL_RemovePath(path.c_str())) {
+            removed++;
+        }
+    }
+
+    if (removed > 0) {
+        LOG("Removed %d stale audio cache files", removed);
+    }
+}
+#else
+uint64_t audio_cache_key(const void *, size_t, SDL_AudioFormat, int) { return 0; }
+std::optional<Audio> audio_cache_load(uint64_t) { return {}; }
+void audio_cache_store(uint64_t, const Audio &) {}
+void audio_cache_prune() {}
+#endif
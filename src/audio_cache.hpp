@@ -0,0 +1,26 @@
+#pragma once
+
+#include <SDL3/SDL_audio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "audio.hpp"
+
+// Decoded PCM kept on disk between launches so a cold start skips decoding.
+// Entries are keyed by the compressed file contents, the decode format and rate, and AUDIO_CACHE_VERSION.
+// Only built with PCM_CACHE (desktop), otherwise loads always miss and stores do nothing.
+
+// Bump whenever decoder or resampler output changes, old entries then simply miss
+constexpr uint32_t AUDIO_CACHE_VERSION = 1;
+
+uint64_t audio_cache_key(const void *data, size_t size, SDL_AudioFormat format, int freq);
+
+// Safe to call from a worker thread
+std::optional<Audio> audio_cache_load(uint64_t key);
+void audio_cache_store(uint64_t key, const Audio &audio);
+
+// Delete entries no load asked for this session and temp files left by a crash.
+// Call once every sound effect has loaded, another instance using different assets re-decodes next launch.
+void audio_cache_prune();
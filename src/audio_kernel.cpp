@@ -0,0 +1,322 @@
+#include "audio_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(AUDIO_KERNEL_NO_SIMD)
+// scalar only, for comparison
+#elif defined(__SSE2__) || defined(_M_X64)
+#define AUDIO_KERNEL_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define AUDIO_KERNEL_NEON
+#include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+#define AUDIO_KERNEL_WASM
+#include <wasm_simd128.h>
+#endif
+
+namespace {
+constexpr float S16_TO_F32 = 1.0f / 32768.0f;
+constexpr float F32_TO_S16 = 32767.0f;
+
+int16_t to_s16(float x) {
+    return static_cast<int16_t>(std::clamp(std::lrint(x), -32768L, 32767L));
+}
+
+}  // namespace
+
+// Each kernel runs the vector loop over multiples of 8 samples, then finishes the tail in scalar
+
+void gain_s16(int16_t *data, size_t n, float gain) {
+    size_t i = 0;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+        lo = _mm_mul_ps(lo, g);
+        hi = _mm_mul_ps(hi, g);
+        x = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), x);
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vld1q_s16(data + i);
+        float32x4_t lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), gain);
+        float32x4_t hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), gain);
+        x = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)), vqmovn_s32(vcvtnq_s32_f32(hi)));
+        vst1q_s16(data + i, x);
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t g = wasm_f32x4_splat(gain);
+    for (; i + 8 <= n; i += 8) {
+        v128_t x = wasm_v128_load(data + i);
+        v128_t lo = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(x)), g);
+        v128_t hi = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_i32x4_extend_high_i16x8(x)), g);
+        lo = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(lo));
+        hi = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(hi));
+        wasm_v128_store(data + i, wasm_i16x8_narrow_i32x4(lo, hi));
+    }
+#endif
+
+    for (; i < n; i++) {
+        data[i] = to_s16(static_cast<float>(data[i]) * gain);
+    }
+}
+
+void gain_f32(float *data, size_t n, float gain) {
+    size_t i = 0;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), g));
+        _mm_storeu_ps(data + i + 4, _mm_mul_ps(_mm_loadu_ps(data + i + 4), g));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    for (; i + 8 <= n; i += 8) {
+        vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), gain));
+        vst1q_f32(data + i + 4, vmulq_n_f32(vld1q_f32(data + i + 4), gain));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t g = wasm_f32x4_splat(gain);
+    for (; i + 8 <= n; i += 8) {
+        wasm_v128_store(data + i, wasm_f32x4_mul(wasm_v128_load(data + i), g));
+        wasm_v128_store(data + i + 4, wasm_f32x4_mul(wasm_v128_load(data + i + 4), g));
+    }
+#endif
+
+    for (; i < n; i++) {
+        data[i] *= gain;
+    }
+}
+
+void mix_s16(float *acc, const int16_t *src, size_t n, float gain) {
+    size_t i = 0;
+    const float scale = gain * S16_TO_F32;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 g = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(lo, g)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(hi, g)));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+        vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), lo, scale));
+        vst1q_f32(acc + i + 4, vmlaq_n_f32(vld1q_f32(acc + i + 4), hi, scale));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t g = wasm_f32x4_splat(scale);
+    for (; i + 8 <= n; i += 8) {
+        v128_t x = wasm_v128_load(src + i);
+        v128_t lo = wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(x));
+        v128_t hi = wasm_f32x4_convert_i32x4(wasm_i32x4_extend_high_i16x8(x));
+        wasm_v128_store(acc + i, wasm_f32x4_add(wasm_v128_load(acc + i), wasm_f32x4_mul(lo, g)));
+        wasm_v128_store(acc + i + 4, wasm_f32x4_add(wasm_v128_load(acc + i + 4), wasm_f32x4_mul(hi, g)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        acc[i] += static_cast<float>(src[i]) * scale;
+    }
+}
+
+void mix_f32(float *acc, const float *src, size_t n, float gain) {
+    size_t i = 0;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(_mm_loadu_ps(src + i + 4), g)));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    for (; i + 8 <= n; i += 8) {
+        vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), vld1q_f32(src + i), gain));
+        vst1q_f32(acc + i + 4, vmlaq_n_f32(vld1q_f32(acc + i + 4), vld1q_f32(src + i + 4), gain));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t g = wasm_f32x4_splat(gain);
+    for (; i + 8 <= n; i += 8) {
+        v128_t a = wasm_f32x4_mul(wasm_v128_load(src + i), g);
+        v128_t b = wasm_f32x4_mul(wasm_v128_load(src + i + 4), g);
+        wasm_v128_store(acc + i, wasm_f32x4_add(wasm_v128_load(acc + i), a));
+        wasm_v128_store(acc + i + 4, wasm_f32x4_add(wasm_v128_load(acc + i + 4), b));
+    }
+#endif
+
+    for (; i < n; i++) {
+        acc[i] += src[i] * gain;
+    }
+}
+
+void mix_s16_mono_to_stereo(float *acc, const int16_t *src, size_t n, float gain) {
+    size_t i = 0;
+    const float scale = gain * S16_TO_F32;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 g = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), g);
+        __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), g);
+        float *out = acc + i * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(lo, lo)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(lo, lo)));
+        _mm_storeu_ps(out + 8, _mm_add_ps(_mm_loadu_ps(out + 8), _mm_unpacklo_ps(hi, hi)));
+        _mm_storeu_ps(out + 12, _mm_add_ps(_mm_loadu_ps(out + 12), _mm_unpackhi_ps(hi, hi)));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vld1q_s16(src + i);
+        float32x4_t lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale);
+        float32x4_t hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale);
+        float *out = acc + i * 2;
+        vst1q_f32(out, vaddq_f32(vld1q_f32(out), vzip1q_f32(lo, lo)));
+        vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), vzip2q_f32(lo, lo)));
+        vst1q_f32(out + 8, vaddq_f32(vld1q_f32(out + 8), vzip1q_f32(hi, hi)));
+        vst1q_f32(out + 12, vaddq_f32(vld1q_f32(out + 12), vzip2q_f32(hi, hi)));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t g = wasm_f32x4_splat(scale);
+    for (; i + 8 <= n; i += 8) {
+        v128_t x = wasm_v128_load(src + i);
+        v128_t lo = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_i32x4_extend_low_i16x8(x)), g);
+        v128_t hi = wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_i32x4_extend_high_i16x8(x)), g);
+        float *out = acc + i * 2;
+        wasm_v128_store(out, wasm_f32x4_add(wasm_v128_load(out), wasm_i32x4_shuffle(lo, lo, 0, 0, 1, 1)));
+        wasm_v128_store(out + 4, wasm_f32x4_add(wasm_v128_load(out + 4), wasm_i32x4_shuffle(lo, lo, 2, 2, 3, 3)));
+        wasm_v128_store(out + 8, wasm_f32x4_add(wasm_v128_load(out + 8), wasm_i32x4_shuffle(hi, hi, 0, 0, 1, 1)));
+        wasm_v128_store(out + 12, wasm_f32x4_add(wasm_v128_load(out + 12), wasm_i32x4_shuffle(hi, hi, 2, 2, 3, 3)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        float s = static_cast<float>(src[i]) * scale;
+        acc[i * 2] += s;
+        acc[i * 2 + 1] += s;
+    }
+}
+
+void mix_f32_mono_to_stereo(float *acc, const float *src, size_t n, float gain) {
+    size_t i = 0;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 8 <= n; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(src + i), g);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(src + i + 4), g);
+        float *out = acc + i * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(lo, lo)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(lo, lo)));
+        _mm_storeu_ps(out + 8, _mm_add_ps(_mm_loadu_ps(out + 8), _mm_unpacklo_ps(hi, hi)));
+        _mm_storeu_ps(out + 12, _mm_add_ps(_mm_loadu_ps(out + 12), _mm_unpackhi_ps(hi, hi)));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t lo = vmulq_n_f32(vld1q_f32(src + i), gain);
+        float32x4_t hi = vmulq_n_f32(vld1q_f32(src + i + 4), gain);
+        float *out = acc + i * 2;
+        vst1q_f32(out, vaddq_f32(vld1q_f32(out), vzip1q_f32(lo, lo)));
+        vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), vzip2q_f32(lo, lo)));
+        vst1q_f32(out + 8, vaddq_f32(vld1q_f32(out + 8), vzip1q_f32(hi, hi)));
+        vst1q_f32(out + 12, vaddq_f32(vld1q_f32(out + 12), vzip2q_f32(hi, hi)));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t g = wasm_f32x4_splat(gain);
+    for (; i + 8 <= n; i += 8) {
+        v128_t lo = wasm_f32x4_mul(wasm_v128_load(src + i), g);
+        v128_t hi = wasm_f32x4_mul(wasm_v128_load(src + i + 4), g);
+        float *out = acc + i * 2;
+        wasm_v128_store(out, wasm_f32x4_add(wasm_v128_load(out), wasm_i32x4_shuffle(lo, lo, 0, 0, 1, 1)));
+        wasm_v128_store(out + 4, wasm_f32x4_add(wasm_v128_load(out + 4), wasm_i32x4_shuffle(lo, lo, 2, 2, 3, 3)));
+        wasm_v128_store(out + 8, wasm_f32x4_add(wasm_v128_load(out + 8), wasm_i32x4_shuffle(hi, hi, 0, 0, 1, 1)));
+        wasm_v128_store(out + 12, wasm_f32x4_add(wasm_v128_load(out + 12), wasm_i32x4_shuffle(hi, hi, 2, 2, 3, 3)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        float s = src[i] * gain;
+        acc[i * 2] += s;
+        acc[i * 2 + 1] += s;
+    }
+}
+
+void saturate_f32(float *data, size_t n) {
+    size_t i = 0;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_ps(data + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + i), lo), hi));
+        _mm_storeu_ps(data + i + 4, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + i + 4), lo), hi));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    for (; i + 8 <= n; i += 8) {
+        vst1q_f32(data + i, vminq_f32(vmaxq_f32(vld1q_f32(data + i), lo), hi));
+        vst1q_f32(data + i + 4, vminq_f32(vmaxq_f32(vld1q_f32(data + i + 4), lo), hi));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t lo = wasm_f32x4_splat(-1.0f);
+    const v128_t hi = wasm_f32x4_splat(1.0f);
+    for (; i + 8 <= n; i += 8) {
+        wasm_v128_store(data + i, wasm_f32x4_pmin(wasm_f32x4_pmax(wasm_v128_load(data + i), lo), hi));
+        wasm_v128_store(data + i + 4, wasm_f32x4_pmin(wasm_f32x4_pmax(wasm_v128_load(data + i + 4), lo), hi));
+    }
+#endif
+
+    for (; i < n; i++) {
+        data[i] = std::clamp(data[i], -1.0f, 1.0f);
+    }
+}
+
+void saturate_f32_to_s16(int16_t *out, const float *in, size_t n) {
+    size_t i = 0;
+
+#if defined(AUDIO_KERNEL_SSE2)
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 s = _mm_set1_ps(F32_TO_S16);
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi), s);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi), s);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+#elif defined(AUDIO_KERNEL_NEON)
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(in + i), lo), hi), F32_TO_S16);
+        float32x4_t b = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(in + i + 4), lo), hi), F32_TO_S16);
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+#elif defined(AUDIO_KERNEL_WASM)
+    const v128_t lo = wasm_f32x4_splat(-1.0f);
+    const v128_t hi = wasm_f32x4_splat(1.0f);
+    const v128_t s = wasm_f32x4_splat(F32_TO_S16);
+    for (; i + 8 <= n; i += 8) {
+        v128_t a = wasm_f32x4_mul(wasm_f32x4_pmin(wasm_f32x4_pmax(wasm_v128_load(in + i), lo), hi), s);
+        v128_t b = wasm_f32x4_mul(wasm_f32x4_pmin(wasm_f32x4_pmax(wasm_v128_load(in + i + 4), lo), hi), s);
+        a = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(a));
+        b = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(b));
+        wasm_v128_store(out + i, wasm_i16x8_narrow_i32x4(a, b));
+    }
+#endif
+
+    for (; i < n; i++) {
+        out[i] = to_s16(std::clamp(in[i], -1.0f, 1.0f) * F32_TO_S16);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Sample kernels for the mixer, vectorized with SSE2, NEON (aarch64) or WASM SIMD128
+// when the compiler targets them, scalar otherwise or with AUDIO_KERNEL_NO_SIMD defined.
+// Float samples are in [-1, 1], n counts samples not frames.
+
+// data *= gain, saturating
+void gain_s16(int16_t *data, size_t n, float gain);
+void gain_f32(float *data, size_t n, float gain);
+
+// acc += src * gain, S16 is scaled to [-1, 1]
+void mix_s16(float *acc, const int16_t *src, size_t n, float gain);
+void mix_f32(float *acc, const float *src, size_t n, float gain);
+
+// acc += mono src * gain into both channels of interleaved stereo, n is the mono sample count
+void mix_s16_mono_to_stereo(float *acc, const int16_t *src, size_t n, float gain);
+void mix_f32_mono_to_stereo(float *acc, const float *src, size_t n, float gain);
+
+// Clamp to [-1, 1]
+void saturate_f32(float *data, size_t n);
+void saturate_f32_to_s16(int16_t *out, const float *in, size_t n);
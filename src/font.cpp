@@ -2,23 +2,39 @@
 
 #include <SDL3/SDL_surface.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
 #include <sstream>
+#include <string>
 
 #include "gl_helper.hpp"
 #include "log.hpp"
 
 namespace {
+// std140, matches FrameUniform and FontDrawUniform
 const char *font_vertex_shader = R"(#version 300 es
 precision mediump float;    
 
 layout(location = 0) in vec2 pos;
 layout(location = 1) in vec2 atlas_tex_coord;
 
-uniform mat4 ortho_matrix;
-uniform vec2 trans;
-uniform float font_width;
+layout(std140) uniform Frame {
+    highp mat4 ortho_matrix;
+    highp float display_width;
+};
+
+layout(std140) uniform FontDraw {
+    highp vec4 fg_color;
+    highp vec4 bg_color;
+    highp vec4 outline_color;
+    highp vec2 trans;
+    highp float font_width;
+    highp float outline_factor;
+};
+
 out vec2 texCoord;
 
 void main() {
@@ -26,21 +42,88 @@ void main() {
     texCoord = atlas_tex_coord;
 })";
 
-const char *font_fragment_shader = R"(#version 300 es
+const char *font_fragment_shader_header = R"(#version 300 es
+precision mediump float;
+
+in vec2 texCoord;
+out vec4 color;
+uniform sampler2D msdf;
+uniform float distance_range;
+uniform float grid_width;
+
+layout(std140) uniform Frame {
+    highp mat4 ortho_matrix;
+    highp float display_width;
+};
+
+layout(std140) uniform FontDraw {
+    highp vec4 fg_color;
+    highp vec4 bg_color;
+    highp vec4 outline_color;
+    highp vec2 trans;
+    highp float font_width;
+    highp float outline_factor;
+};
+)";
+
+// Per glyph instance, the unit quad corner is expanded into the glyph plane and uv rectangle.
+const char *font_instanced_vertex_shader = R"(#version 300 es
+precision mediump float;
+
+layout(location = 0) in vec2 corner;
+layout(location = 2) in vec4 plane; // x0, y0, x1, y1
+layout(location = 3) in vec4 uv; // u0, v0, u1, v1
+layout(location = 4) in vec4 param; // trans.xy, font_width, outline_factor
+layout(location = 5) in vec4 fg;
+layout(location = 6) in vec4 bg;
+layout(location = 7) in vec4 outline;
+
+layout(std140) uniform Frame {
+    highp mat4 ortho_matrix;
+    highp float display_width;
+};
+
+out vec2 texCoord;
+flat out vec4 fg_color;
+flat out vec4 bg_color;
+flat out vec4 outline_color;
+flat out float outline_factor;
+flat out float font_width;
+
+void main() {
+    vec2 pos = mix(plane.xy, plane.zw, corner);
+    gl_Position = ortho_matrix * vec4(pos*param.z + param.xy, 0.0, 1.0);
+    texCoord = mix(uv.xy, uv.zw, corner);
+
+    fg_color = fg;
+    bg_color = bg;
+    outline_color = outline;
+    outline_factor = param.w;
+    font_width = param.z;
+})";
+
+const char *font_instanced_fragment_shader_header = R"(#version 300 es
 precision mediump float;
 
 in vec2 texCoord;
 out vec4 color;
 uniform sampler2D msdf;
-uniform vec4 bg_color;
-uniform vec4 fg_color;
-uniform vec4 outline_color;
-uniform float outline_factor;
+flat in vec4 bg_color;
+flat in vec4 fg_color;
+flat in vec4 outline_color;
+flat in float outline_factor;
+flat in float font_width;
 uniform float distance_range;
 uniform float grid_width;
-uniform float display_width;
-uniform float font_width;
 
+layout(std140) uniform Frame {
+    highp mat4 ortho_matrix;
+    highp float display_width;
+};
+)";
+
+// Shared by both the uniform and instanced variant
+const char *font_fragment_shader_main = R"(
 float median(float r, float g, float b) {
     return max(min(r, g), min(max(r, g), b));
 }
@@ -76,8 +159,129 @@ void main() {
         color = mix(bg_color, fg_color, opacity);
     }
 })";
+
+// Binary atlas produced by scripts/font_atlas_to_bin.py, little endian, no padding.
+//
+// AtlasHeader
+// AtlasGlyph[glyph_count]
+// texel payload[texel_bytes], RGB8 rows top to bottom, tightly packed
+constexpr char ATLAS_MAGIC[4] = {'N', 'S', 'G', 'A'};
+constexpr uint32_t ATLAS_VERSION = 1;
+constexpr uint32_t ATLAS_TEX_RGB8 = 0;
+
+struct AtlasHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t distance_range;
+    float em_size;
+    int32_t grid_width;
+    int32_t grid_height;
+    int32_t tex_width;
+    int32_t tex_height;
+    uint32_t tex_format;
+    uint32_t glyph_count;
+    uint32_t texel_bytes;
+    uint32_t reserved;
+};
+
+struct AtlasGlyph {
+    int32_t unicode;
+    float advance;
+    float plane_left;
+    float plane_bottom;
+    float plane_right;
+    float plane_top;
+    float atlas_left;
+    float atlas_bottom;
+    float atlas_right;
+    float atlas_top;
+};
+
+static_assert(sizeof(AtlasHeader) == 48);
+static_assert(sizeof(AtlasGlyph) == 40);
 }  // namespace
 
+bool FontAtlas::load_binary(const std::string &atlas_bin) {
+    size_t data_size;
+    uint8_t *data = static_cast<uint8_t *>(SDL_LoadFile(atlas_bin.c_str(), &data_size));
+
+    // not an error, the caller falls back to the text atlas
+    if (!data) {
+        return false;
+    }
+
+    bool ok = parse_binary(data, data_size);
+    SDL_free(data);
+
+    return ok;
+}
+
+bool FontAtlas::parse_binary(const uint8_t *data, size_t data_size) {
+    AtlasHeader h;
+
+    if (data_size < sizeof(h)) {
+        LOG("font atlas: truncated header");
+        return false;
+    }
+
+    memcpy(&h, data, sizeof(h));
+
+    if (memcmp(h.magic, ATLAS_MAGIC, sizeof(ATLAS_MAGIC)) != 0 || h.version != ATLAS_VERSION) {
+        LOG("font atlas: bad magic or version %d", h.version);
+        return false;
+    }
+
+    if (h.tex_format != ATLAS_TEX_RGB8) {
+        LOG("font atlas: unsupported texel format %d", h.tex_format);
+        return false;
+    }
+
+    size_t glyph_bytes = sizeof(AtlasGlyph) * h.glyph_count;
+    size_t expected_texel = static_cast<size_t>(h.tex_width) * static_cast<size_t>(h.tex_height) * 3;
+
+    if (h.texel_bytes != expected_texel || data_size < sizeof(h) + glyph_bytes + h.texel_bytes) {
+        LOG("font atlas: size mismatch");
+        return false;
+    }
+
+    distance_range = h.distance_range;
+    em_size = h.em_size;
+    grid_width = h.grid_width;
+    grid_height = h.grid_height;
+
+    const uint8_t *texel = data + sizeof(h) + glyph_bytes;
+    tex = make_texture(h.tex_width, h.tex_height, texel, 1);
+
+    if (!tex) {
+        return false;
+    }
+
+    glyph = {};
+
+    for (uint32_t i = 0; i < h.glyph_count; i++) {
+        AtlasGlyph a;
+        memcpy(&a, data + sizeof(h) + sizeof(AtlasGlyph) * i, sizeof(a));
+
+        Glyph g{};
+        g.advance = a.advance;
+        g.plane_left = a.plane_left;
+        g.plane_bottom = a.plane_bottom;
+        g.plane_right = a.plane_right;
+        g.plane_top = a.plane_top;
+        g.atlas_left = a.atlas_left;
+        g.atlas_bottom = a.atlas_bottom;
+        g.atlas_right = a.atlas_right;
+        g.atlas_top = a.atlas_top;
+
+        make_glyph_template(g);
+        glyph.insert(a.unicode, g);
+    }
+
+    glyph.finalize();
+
+    return true;
+}
+
 bool FontAtlas::load(const std::string &atlas_path, const std::string &atlas_txt) {
     tex = make_texture(atlas_path);
 
@@ -85,10 +289,6 @@ bool FontAtlas::load(const std::string &atlas_path, const std::string &atlas_txt
         return false;
     }
 
-    // quad for letter
-    std::vector<glm::vec4> empty_vert(4);
-    std::vector<uint32_t> index{0, 1, 2, 0, 2, 3};
-
     size_t data_size;
     char *data = static_cast<char *>(SDL_LoadFile(atlas_txt.c_str(), &data_size));
 
@@ -98,6 +298,12 @@ bool FontAtlas::load(const std::string &atlas_path, const std::string &atlas_txt
     }
 
     std::string str(data);
+    SDL_free(data);
+
+    return parse_text(str);
+}
+
+bool FontAtlas::parse_text(const std::string &str) {
     std::stringstream ss(str);
 
     std::string label;
@@ -135,155 +341,351 @@ bool FontAtlas::load(const std::string &atlas_path, const std::string &atlas_txt
         ss >> g.atlas_right;
         ss >> g.atlas_top;
 
-        glyph[unicode] = g;
+        make_glyph_template(g);
+        glyph.insert(unicode, g);
     }
 
+    glyph.finalize();
+
     return true;
 }
 
-std::pair<glm::vec2, glm::vec2> FontAtlas::get_char_uv(char ch) {
-    const Glyph &g = glyph[static_cast<int>(ch)];
+void FontAtlas::make_glyph_template(Glyph &g) const {
+    float tw = static_cast<float>(tex->width);
+    float th = static_cast<float>(tex->height);
+    float gw = static_cast<float>(grid_width);
 
-    float w = static_cast<float>(tex->width);
-    float h = static_cast<float>(tex->height);
-    glm::vec2 start{g.atlas_left / w, 1 - g.atlas_bottom / h};
-    glm::vec2 end{g.atlas_right / w, 1 - g.atlas_top / h};
+    // quad relative to the cursor, y points down
+    float x0 = g.plane_left * em_size;
+    float y0 = std::abs(g.plane_bottom) * em_size;
+    float x1 = x0 + (g.atlas_right - g.atlas_left);
+    float y1 = y0 - (g.atlas_top - g.atlas_bottom);
 
-    return {start, end};
+    g.quad.plane = glm::vec4{x0, y0, x1, y1} * (1.f / gw);
+    g.quad.uv = {g.atlas_left / tw, 1 - g.atlas_bottom / th, g.atlas_right / tw, 1 - g.atlas_top / th};
+    g.norm_advance = g.advance * em_size / gw;
 }
 
-std::vector<glm::vec4> FontAtlas::make_letter(float x, float y, char ch) {
-    auto [start, end] = get_char_uv(ch);
+void GlyphTable::insert(int unicode, const Glyph &g) {
+    if (unicode >= 0 && unicode < DENSE_SIZE) {
+        if (dense.empty()) {
+            dense.resize(DENSE_SIZE);
+        }
+
+        dense[static_cast<size_t>(unicode)] = g;
+    } else {
+        sparse.emplace_back(unicode, g);
+    }
+}
 
-    const Glyph &g = glyph[static_cast<int>(ch)];
+void GlyphTable::finalize() {
+    auto less = [](const auto &a, const auto &b) { return a.first < b.first; };
+    std::stable_sort(sparse.begin(), sparse.end(), less);
 
-    float w = (g.atlas_right - g.atlas_left);
-    float h = (g.atlas_top - g.atlas_bottom);
-    float xoff = g.plane_left * em_size;
-    float yoff = std::abs(g.plane_bottom) * em_size;
+    // keep the last definition of a duplicate, same as the old map assignment
+    auto last = std::unique(sparse.rbegin(), sparse.rend(), [](const auto &a, const auto &b) {
+        return a.first == b.first;
+    });
+    sparse.erase(sparse.begin(), last.base());
+}
 
-    x += xoff;
-    y += yoff;
+const Glyph &GlyphTable::get(int unicode) const {
+    static const Glyph empty{};
 
-    // pos + uv
-    return std::vector<glm::vec4>{
-        {x, y, start.x, start.y},
-        {x + w, y, end.x, start.y},
-        {x + w, y - h, end.x, end.y},
-        {x, y - h, start.x, end.y},
-    };
+    if (unicode >= 0 && unicode < DENSE_SIZE) {
+        return dense.empty() ? empty : dense[static_cast<size_t>(unicode)];
+    }
+
+    auto it = std::lower_bound(
+        sparse.begin(), sparse.end(), unicode, [](const auto &a, int u) { return a.first < u; });
+
+    if (it != sparse.end() && it->first == unicode) {
+        return it->second;
+    }
+
+    return empty;
 }
 
-std::pair<std::vector<glm::vec4>, std::vector<uint32_t>> FontAtlas::make_text_vertex(const std::string &str,
-                                                                                     bool normalize) {
-    float xpos = 0;
+int decode_utf8(std::string_view str, size_t &pos) {
+    constexpr int REPLACEMENT = 0xfffd;
 
-    std::vector<glm::vec4> vertex_uv;
-    std::vector<uint32_t> index;
+    auto byte = [&](size_t i) { return static_cast<unsigned char>(str[i]); };
+
+    unsigned char c = byte(pos++);
 
-    uint32_t vertex_count = 0;
+    if (c < 0x80) {
+        return c;
+    }
 
-    for (char ch : str) {
-        auto v = make_letter(xpos, 0, ch);
+    int len = 0;
+    int cp = 0;
+
+    if ((c & 0xe0) == 0xc0) {
+        len = 1;
+        cp = c & 0x1f;
+    } else if ((c & 0xf0) == 0xe0) {
+        len = 2;
+        cp = c & 0x0f;
+    } else if ((c & 0xf8) == 0xf0) {
+        len = 3;
+        cp = c & 0x07;
+    } else {
+        return REPLACEMENT;
+    }
 
-        if (normalize) {
-            for (auto &v_ : v) {
-                v_.x /= static_cast<float>(grid_width);
-                v_.y /= static_cast<float>(grid_width);
-            }
+    for (int i = 0; i < len; i++) {
+        if (pos >= str.size() || (byte(pos) & 0xc0) != 0x80) {
+            return REPLACEMENT;
         }
 
-        vertex_uv.insert(vertex_uv.end(), v.begin(), v.end());
+        cp = (cp << 6) | (byte(pos++) & 0x3f);
+    }
 
-        const Glyph &g = glyph[static_cast<int>(ch)];
-        xpos += g.advance * em_size;
+    // overlong encodings, UTF-16 surrogates and anything past U+10FFFF
+    constexpr int MIN_CP[] = {0, 0x80, 0x800, 0x10000};
 
-        // quad
-        std::vector<uint32_t> idx{0, 1, 2, 0, 2, 3};
-        for (auto &i : idx) {
-            i += vertex_count;
-        }
-        index.insert(index.end(), idx.begin(), idx.end());
+    if (cp < MIN_CP[len] || (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff) {
+        return REPLACEMENT;
+    }
+
+    return cp;
+}
 
-        vertex_count += 4;
+size_t FontAtlas::write_glyph_quad(std::string_view str, bool normalize, std::span<GlyphQuad> out) const {
+    float scale = normalize ? 1.f : static_cast<float>(grid_width);
+    float xpos = 0;
+    size_t pos = 0;
+    size_t i = 0;
+
+    for (; i < out.size() && pos < str.size(); i++) {
+        const Glyph &g = glyph.get(decode_utf8(str, pos));
+        const glm::vec4 &p = g.quad.plane;
+
+        out[i].plane = glm::vec4{p.x + xpos, p.y, p.z + xpos, p.w} * scale;
+        out[i].uv = g.quad.uv;
+
+        xpos += g.norm_advance;
+    }
+
+    return i;
+}
+
+size_t FontAtlas::write_text_vertex(std::string_view str,
+                                    bool normalize,
+                                    std::span<glm::vec4> vertex_uv,
+                                    std::span<uint32_t> index,
+                                    uint32_t base_vertex) const {
+    float scale = normalize ? 1.f : static_cast<float>(grid_width);
+    size_t n = std::min(vertex_uv.size() / 4, index.size() / 6);
+    float xpos = 0;
+    size_t pos = 0;
+    size_t i = 0;
+
+    for (; i < n && pos < str.size(); i++) {
+        const Glyph &g = glyph.get(decode_utf8(str, pos));
+        const glm::vec4 &p = g.quad.plane;
+        const glm::vec4 &uv = g.quad.uv;
+
+        float x0 = (p.x + xpos) * scale;
+        float y0 = p.y * scale;
+        float x1 = (p.z + xpos) * scale;
+        float y1 = p.w * scale;
+
+        // pos + uv, top-left, top-right, bottom-right, bottom-left
+        glm::vec4 *v = &vertex_uv[i * 4];
+        v[0] = {x0, y0, uv.x, uv.y};
+        v[1] = {x1, y0, uv.z, uv.y};
+        v[2] = {x1, y1, uv.z, uv.w};
+        v[3] = {x0, y1, uv.x, uv.w};
+
+        uint32_t k = base_vertex + static_cast<uint32_t>(i * 4);
+        uint32_t *idx = &index[i * 6];
+        idx[0] = k;
+        idx[1] = k + 1;
+        idx[2] = k + 2;
+        idx[3] = k;
+        idx[4] = k + 2;
+        idx[5] = k + 3;
+
+        xpos += g.norm_advance;
     }
 
+    return i;
+}
+
+std::pair<std::vector<glm::vec4>, std::vector<uint32_t>> FontAtlas::make_text_vertex(const std::string &str,
+                                                                                     bool normalize) {
+    std::vector<glm::vec4> vertex_uv;
+    std::vector<uint32_t> index;
+
+    make_text_vertex(str, normalize, vertex_uv, index);
+
     return {vertex_uv, index};
 }
 
+void FontAtlas::make_text_vertex(const std::string &str,
+                                 bool normalize,
+                                 std::vector<glm::vec4> &vertex_uv,
+                                 std::vector<uint32_t> &index) {
+    // byte count is an upper bound on the glyph count
+    vertex_uv.resize(str.size() * 4);
+    index.resize(str.size() * 6);
+
+    size_t n = write_text_vertex(str, normalize, vertex_uv, index);
+
+    vertex_uv.resize(n * 4);
+    index.resize(n * 6);
+}
+
 std::pair<VertexBufferPtr, BBox> FontAtlas::make_text(const std::string &str, bool normalize) {
     auto [vertex_uv, index] = make_text_vertex(str, normalize);
     return {make_vertex_buffer(vertex_uv, index), bbox(vertex_uv)};
 }
 
-bool FontShader::init(const FontAtlas &font_atlas) {
-    shader = make_shader(font_vertex_shader, font_fragment_shader);
-
-    if (shader) {
-        shader->use();
-        glUniform1i(shader->get_loc("msdf"), 0);
-        set_font_distance_range(static_cast<float>(font_atlas.distance_range));
-        set_font_grid_width(static_cast<float>(font_atlas.grid_width));
+const TextMesh &FontAtlas::get_text(const std::string &str, bool normalize) {
+    TextMesh &mesh = text_cache[{str, normalize}];
 
-        return true;
+    if (!mesh.vertex_buffer) {
+        mesh.set(*this, str, normalize);
     }
 
-    return false;
+    return mesh;
 }
 
-void FontShader::set_trans(const glm::vec2 &trans) const {
-    assert(shader);
-    shader->use();
-    glUniform2fv(shader->get_loc("trans"), 1, glm::value_ptr(trans));
-}
+bool TextMesh::set(FontAtlas &font, const std::string &new_str, bool new_normalize) {
+    if (vertex_buffer && new_str == str && new_normalize == normalize) {
+        return false;
+    }
 
-void FontShader::set_font_grid_width(float grid_width) const {
-    assert(shader);
-    glUniform1f(shader->get_loc("grid_width"), grid_width);
-}
+    str = new_str;
+    normalize = new_normalize;
 
-void FontShader::set_font_width(float font_width) const {
-    assert(shader);
-    glUniform1f(shader->get_loc("font_width"), font_width);
-}
+    font.make_text_vertex(str, normalize, vertex_uv, index);
+
+    size_t glyphs = vertex_uv.size() / 4;
+    bbox = glyphs > 0 ? ::bbox(vertex_uv) : BBox{};
 
-void FontShader::set_font_distance_range(float range) const {
-    assert(shader);
-    glUniform1f(shader->get_loc("distance_range"), range);
+    if (!vertex_buffer || glyphs > capacity) {
+        capacity = std::max({glyphs, capacity * 2, MIN_CAPACITY});
+
+        // allocate for the full capacity, only the used part is drawn
+        vertex_uv.resize(capacity * 4);
+        index.resize(capacity * 6);
+        vertex_buffer = make_vertex_buffer(vertex_uv, index);
+    } else if (glyphs > 0) {
+        vertex_buffer->update_vertex(glm::value_ptr(vertex_uv[0]), sizeof(glm::vec4) * vertex_uv.size(), index);
+    }
+
+    vertex_buffer->index_count = glyphs * 6;
+
+    return true;
 }
 
-void FontShader::set_fg(const glm::vec4 &color) const {
-    assert(shader);
-    shader->use();
-    glUniform4fv(shader->get_loc("fg_color"), 1, glm::value_ptr(color));
+BBox bbox(const std::vector<GlyphQuad> &quad) {
+    if (quad.empty()) {
+        return {};
+    }
+
+    glm::vec2 start{quad[0].plane.x, quad[0].plane.y};
+    glm::vec2 end = start;
+
+    for (const auto &q : quad) {
+        glm::vec2 p0{q.plane.x, q.plane.y};
+        glm::vec2 p1{q.plane.z, q.plane.w};
+
+        start = glm::min(start, glm::min(p0, p1));
+        end = glm::max(end, glm::max(p0, p1));
+    }
+
+    return {start, end};
 }
 
-void FontShader::set_bg(const glm::vec4 &color) const {
-    assert(shader);
-    shader->use();
-    glUniform4fv(shader->get_loc("bg_color"), 1, glm::value_ptr(color));
+std::vector<GlyphQuad> FontAtlas::make_glyph_quad(const std::string &str, bool normalize) {
+    std::vector<GlyphQuad> ret(str.size());
+    ret.resize(write_glyph_quad(str, normalize, ret));
+    return ret;
 }
 
-void FontShader::set_outline(const glm::vec4 &color) const {
-    assert(shader);
-    shader->use();
-    glUniform4fv(shader->get_loc("outline_color"), 1, glm::value_ptr(color));
+void TextBatch::add(const std::vector<GlyphQuad> &quad, const glm::vec2 &trans, const TextStyle &style) {
+    for (const auto &q : quad) {
+        GlyphInstance g;
+        g.plane = q.plane;
+        g.uv = q.uv;
+        g.param = {trans.x, trans.y, style.font_width, style.outline_factor};
+        g.fg = style.fg;
+        g.bg = style.bg;
+        g.outline = style.outline;
+
+        instance.push_back(g);
+    }
 }
 
-void FontShader::set_outline_factor(float factor) const {
-    assert(shader);
-    shader->use();
-    glUniform1f(shader->get_loc("outline_factor"), factor);
+void draw_text_batch(const FontShader &font_shader, const FontAtlas &font_atlas, const TextBatch &batch) {
+    const InstanceBufferPtr &inst = font_shader.instance_buffer;
+
+    inst->update(batch.instance.data(), batch.instance.size());
+    draw_vertex_buffer_instanced(font_shader.instanced_shader, font_shader.unit_quad, inst, font_atlas.tex);
 }
 
-void FontShader::set_ortho(const glm::mat4 &ortho) const {
-    assert(shader);
-    shader->use();
-    glUniformMatrix4fv(shader->get_loc("ortho_matrix"), 1, GL_FALSE, glm::value_ptr(ortho));
+bool FontShader::init(const FontAtlas &font_atlas) {
+    std::string fragment = std::string(font_fragment_shader_header) + font_fragment_shader_main;
+    shader = make_shader(font_vertex_shader, fragment.c_str());
+
+    if (!shader) {
+        return false;
+    }
+
+    fragment = std::string(font_instanced_fragment_shader_header) + font_fragment_shader_main;
+    instanced_shader = make_shader(font_instanced_vertex_shader, fragment.c_str());
+
+    if (!instanced_shader) {
+        return false;
+    }
+
+    // atlas constants
+    for (const Shader *s : {shader.get(), instanced_shader.get()}) {
+        s->use();
+        s->get_uniform<int>("msdf").set(0);
+        s->get_uniform<float>("distance_range").set(static_cast<float>(font_atlas.distance_range));
+        s->get_uniform<float>("grid_width").set(static_cast<float>(font_atlas.grid_width));
+        s->bind_uniform_block("Frame", FRAME_UNIFORM_BINDING);
+    }
+
+    shader->bind_uniform_block("FontDraw", FONT_DRAW_UNIFORM_BINDING);
+    draw_uniform = make_uniform_buffer(FONT_DRAW_UNIFORM_BINDING, sizeof(FontDrawUniform), DRAW_UNIFORM_RING);
+
+    std::vector<InstanceAttrib> attrib{
+        {2, 4, offsetof(GlyphInstance, plane)},
+        {3, 4, offsetof(GlyphInstance, uv)},
+        {4, 4, offsetof(GlyphInstance, param)},
+        {5, 4, offsetof(GlyphInstance, fg)},
+        {6, 4, offsetof(GlyphInstance, bg)},
+        {7, 4, offsetof(GlyphInstance, outline)},
+    };
+
+    instance_buffer = make_instance_buffer(sizeof(GlyphInstance), attrib);
+
+    std::vector<glm::vec2> corner{{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}};
+    unit_quad = make_vertex_buffer(corner, {0, 1, 2, 0, 2, 3});
+
+    return true;
 }
 
-void FontShader::set_display_width(float display_width) const {
-    assert(shader);
-    shader->use();
-    glUniform1f(shader->get_loc("display_width"), display_width);
+void FontShader::set_trans(const glm::vec2 &trans) { draw.trans = trans; }
+
+void FontShader::set_font_width(float font_width) { draw.font_width = font_width; }
+
+void FontShader::set_fg(const glm::vec4 &color) { draw.fg_color = color; }
+
+void FontShader::set_bg(const glm::vec4 &color) { draw.bg_color = color; }
+
+void FontShader::set_outline(const glm::vec4 &color) { draw.outline_color = color; }
+
+void FontShader::set_outline_factor(float factor) { draw.outline_factor = factor; }
+
+void draw_text(const FontShader &font_shader, const FontAtlas &font_atlas, const VertexBufferPtr &v) {
+    assert(font_shader.shader);
+
+    font_shader.draw_uniform->bind(font_shader.draw_uniform->push(&font_shader.draw));
+    draw_vertex_buffer(font_shader.shader, v, font_atlas.tex);
 }
@@ -4,10 +4,23 @@
 
 #include <glm/glm.hpp>
 #include <map>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include "gl_helper.hpp"
 
+// Glyph rectangle and its texture coordinates, expanded from a unit quad in the instanced shader
+struct GlyphQuad {
+    glm::vec4 plane;  // x0, y0, x1, y1
+    glm::vec4 uv;     // u0, v0, u1, v1
+};
+
+// Bounding box of the glyph planes, no GL objects involved
+BBox bbox(const std::vector<GlyphQuad> &quad);
+
 // How to render the Glyph
 // Plane is offset relative to cursor pos
 // Atlas is bounding box in the texture atlas
@@ -21,6 +34,45 @@ struct Glyph {
     float atlas_bottom;
     float atlas_right;
     float atlas_top;
+
+    // Precomputed at load, plane and advance are normalized by grid width, uv by texture size
+    GlyphQuad quad;
+    float norm_advance;
+};
+
+// Direct indexed for Basic Latin to Latin Extended-B, sorted vector + binary search for the rest.
+struct GlyphTable {
+    static constexpr int DENSE_SIZE = 0x250;
+
+    std::vector<Glyph> dense;  // empty glyph where missing
+    std::vector<std::pair<int, Glyph>> sparse;
+
+    void insert(int unicode, const Glyph &g);
+    void finalize();                       // call after the last insert
+    const Glyph &get(int unicode) const;  // empty glyph if missing
+};
+
+// Decode one code point starting at pos and advance pos past it. Invalid sequences give U+FFFD.
+int decode_utf8(std::string_view str, size_t &pos);
+
+struct FontAtlas;
+
+// Text vertex buffer that lives across frames, e.g. a score or timer.
+// set() only regenerates when the text changes and rewrites the GL buffer in place unless it has to grow.
+struct TextMesh {
+    static constexpr size_t MIN_CAPACITY = 16;  // glyphs
+
+    std::string str;
+    bool normalize = false;
+    VertexBufferPtr vertex_buffer{{}, {}};
+    BBox bbox{};
+    size_t capacity = 0;  // glyphs the vertex buffer can hold
+
+    // scratch, reused between updates
+    std::vector<glm::vec4> vertex_uv;
+    std::vector<uint32_t> index;
+
+    bool set(FontAtlas &font, const std::string &str, bool normalize);  // true if regenerated
 };
 
 struct FontAtlas {
@@ -30,32 +82,98 @@ struct FontAtlas {
     float em_size;       // pixels per em unit
     int grid_width;
     int grid_height;
-    std::map<int, Glyph> glyph;
+    GlyphTable glyph;
+
+    // Static strings, built on first use and kept for the lifetime of the atlas
+    std::map<std::pair<std::string, bool>, TextMesh> text_cache;
 
     bool load(const std::string &atlas_path, const std::string &atlas_txt);
+    bool load_binary(const std::string &atlas_bin);  // see scripts/font_atlas_to_bin.py
+    bool parse_binary(const uint8_t *data, size_t data_size);
+    bool parse_text(const std::string &atlas_txt_contents);  // tex must be set, only its size is read
     std::pair<VertexBufferPtr, BBox> make_text(const std::string &str, bool normalize);
+    const TextMesh &get_text(const std::string &str, bool normalize);
+
     std::pair<std::vector<glm::vec4>, std::vector<uint32_t>> make_text_vertex(const std::string &str, bool normalize);
+    void make_text_vertex(const std::string &str,
+                          bool normalize,
+                          std::vector<glm::vec4> &vertex_uv,
+                          std::vector<uint32_t> &index);  // reuses the output capacity
+    std::vector<GlyphQuad> make_glyph_quad(const std::string &str, bool normalize);
 
-    std::pair<glm::vec2, glm::vec2> get_char_uv(char ch);
-    std::vector<glm::vec4> make_letter(float x, float y, char ch);
+    // Allocation free, write into caller owned memory and return the number of glyphs written.
+    // str is UTF-8. Output is truncated if it's too small, 4 vertex + 6 index per glyph.
+    size_t write_text_vertex(std::string_view str,
+                             bool normalize,
+                             std::span<glm::vec4> vertex_uv,
+                             std::span<uint32_t> index,
+                             uint32_t base_vertex = 0) const;
+    size_t write_glyph_quad(std::string_view str, bool normalize, std::span<GlyphQuad> out) const;
+
+    void make_glyph_template(Glyph &g) const;
 };
 
+// Per-draw parameters, std140 layout of the FontDraw uniform block
+struct FontDrawUniform {
+    glm::vec4 fg_color{};
+    glm::vec4 bg_color{};
+    glm::vec4 outline_color{};
+    glm::vec2 trans{};
+    float font_width = 0.f;
+    float outline_factor = 0.f;
+};
+
+// Both programs read the shared Frame block (FrameUniform) for the ortho matrix and display width.
 struct FontShader {
     ShaderPtr shader{{}, {}};
 
+    // set_* only change draw, it is uploaded with a single write by draw_text
+    FontDrawUniform draw;
+    UniformBufferPtr draw_uniform{{}, {}};
+
+    // Instanced variant for TextBatch, style comes from the instance buffer.
+    ShaderPtr instanced_shader{{}, {}};
+    InstanceBufferPtr instance_buffer{{}, {}};
+    VertexBufferPtr unit_quad{{}, {}};
+
     bool init(const FontAtlas &font_atlas);
 
-    // call when window resizes
-    void set_ortho(const glm::mat4 &ortho) const;
-    void set_display_width(float display_width) const;
+    void set_font_width(float font_width);
+    void set_trans(const glm::vec2 &trans);
+    void set_fg(const glm::vec4 &color);
+    void set_bg(const glm::vec4 &color);
+    void set_outline(const glm::vec4 &color);
+    void set_outline_factor(float factor);
+};
+
+// Draw a text vertex buffer from FontAtlas::make_text with the current FontShader parameters
+void draw_text(const FontShader &font_shader, const FontAtlas &font_atlas, const VertexBufferPtr &v);
 
-    void set_font_distance_range(float range) const;
-    void set_font_grid_width(float range) const;
-    void set_font_width(float font_width) const;
+struct TextStyle {
+    float font_width;
+    glm::vec4 fg;
+    glm::vec4 bg;
+    glm::vec4 outline;
+    float outline_factor;
+};
 
-    void set_trans(const glm::vec2 &trans) const;
-    void set_fg(const glm::vec4 &color) const;
-    void set_bg(const glm::vec4 &color) const;
-    void set_outline(const glm::vec4 &color) const;
-    void set_outline_factor(float factor) const;
+// Per-instance data for draw_text_batch, matches the instanced shader attributes
+struct GlyphInstance {
+    glm::vec4 plane;
+    glm::vec4 uv;
+    glm::vec4 param;  // trans.xy, font_width, outline_factor
+    glm::vec4 fg;
+    glm::vec4 bg;
+    glm::vec4 outline;
 };
+
+// Glyphs from any number of strings drawn with one instanced call.
+// Clear and refill every frame, the vector keeps its capacity.
+struct TextBatch {
+    std::vector<GlyphInstance> instance;
+
+    void clear() { instance.clear(); }
+    void add(const std::vector<GlyphQuad> &quad, const glm::vec2 &trans, const TextStyle &style);
+};
+
+void draw_text_batch(const FontShader &font_shader, const FontAtlas &font_atlas, const TextBatch &batch);
@@ -0,0 +1,136 @@
+#include "frame_bench.hpp"
+
+#include <SDL3/SDL_timer.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "log.hpp"
+
+namespace {
+struct Summary {
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+template <typename T>
+Summary summarize(std::vector<T> v) {
+    Summary s;
+    if (v.empty()) {
+        return s;
+    }
+
+    std::sort(v.begin(), v.end());
+
+    double sum = 0;
+    for (T x : v) {
+        sum += static_cast<double>(x);
+    }
+
+    auto at = [&](double q) {
+        size_t i = static_cast<size_t>(q * static_cast<double>(v.size() - 1));
+        return static_cast<double>(v[i]);
+    };
+
+    s.mean = sum / static_cast<double>(v.size());
+    s.p50 = at(0.5);
+    s.p99 = at(0.99);
+    s.max = static_cast<double>(v.back());
+
+    return s;
+}
+
+double ns_to_ms(uint64_t ns) { return static_cast<double>(ns) * 1e-6; }
+
+}  // namespace
+
+bool FrameBench::init(int width, int height, GpuTimer *timer) {
+    target = make_framebuffer(width, height);
+    if (!target) {
+        return false;
+    }
+
+    gpu_timer = timer;
+
+    cpu_ms.reserve(static_cast<size_t>(frames));
+    gpu_ms.reserve(static_cast<size_t>(frames));
+    finish_ms.reserve(static_cast<size_t>(frames));
+    draw_calls.reserve(static_cast<size_t>(frames));
+
+    LOG("bench: rendering %d frames at %dx%d offscreen", frames, width, height);
+
+    if (!gpu_timer) {
+        LOG("bench: no timer queries, only the glFinish wait is reported");
+    }
+
+    return true;
+}
+
+void FrameBench::begin_frame() {
+    frame_start = SDL_GetTicksNS();
+    draw_calls_start = gl_state().draw_calls;
+    target->use();
+
+    if (gpu_timer) {
+        gpu_ns_start = gpu_timer->recorded_ns;
+        gpu_dropped_start = gpu_timer->dropped;
+    }
+}
+
+void FrameBench::end_frame() {
+    uint64_t submitted = SDL_GetTicksNS();
+    glFinish();
+    uint64_t finished = SDL_GetTicksNS();
+
+    cpu_ms.push_back(ns_to_ms(submitted - frame_start));
+    finish_ms.push_back(ns_to_ms(finished - submitted));
+    draw_calls.push_back(gl_state().draw_calls - draw_calls_start);
+
+    // after glFinish every query of this frame is available, collect them before the next frame starts
+    if (gpu_timer) {
+        gpu_timer->collect();
+
+        if (gpu_timer->dropped == gpu_dropped_start) {
+            gpu_ms.push_back(ns_to_ms(gpu_timer->recorded_ns - gpu_ns_start));
+        }
+    }
+}
+
+void FrameBench::report() const {
+    Summary cpu = summarize(cpu_ms);
+    Summary finish = summarize(finish_ms);
+    Summary draw = summarize(draw_calls);
+
+    LOG("bench: frames %d", static_cast<int>(cpu_ms.size()));
+    LOG("bench: cpu ms mean %.3f p50 %.3f p99 %.3f max %.3f", cpu.mean, cpu.p50, cpu.p99, cpu.max);
+
+    if (gpu_timer) {
+        Summary gpu = summarize(gpu_ms);
+        LOG("bench: gpu ms (timer query, %d frames) mean %.3f p50 %.3f p99 %.3f max %.3f",
+            static_cast<int>(gpu_ms.size()),
+            gpu.mean,
+            gpu.p50,
+            gpu.p99,
+            gpu.max);
+    }
+
+    LOG("bench: glFinish wait ms mean %.3f p50 %.3f p99 %.3f max %.3f",
+        finish.mean,
+        finish.p50,
+        finish.p99,
+        finish.max);
+    LOG("bench: draw calls mean %.1f max %.0f", draw.mean, draw.max);
+}
+
+int parse_bench_frames(int argc, char *argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--bench-frames") == 0) {
+            return std::max(0, std::atoi(argv[i + 1]));
+        }
+    }
+
+    return 0;
+}
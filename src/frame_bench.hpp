@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "gl_helper.hpp"
+#include "gpu_timer.hpp"
+
+// Headless render benchmark for machines without a display or GPU (SDL offscreen driver + Mesa llvmpipe).
+// Renders a fixed number of frames into an FBO with vsync off and reports per frame
+// - CPU time: start of the frame until everything is submitted
+// - GPU time: execution time of the passes timed by GpuTimer, only with GL_EXT_disjoint_timer_query
+// - finish wait: how long glFinish waits for the submitted work, driver latency included.
+//   Only an upper bound on GPU time, the one number available without the extension.
+// - draw calls issued through gl_helper
+struct FrameBench {
+    int frames = 0;  // frames to render, 0 when not benchmarking
+    FramebufferPtr target{{}, {}};
+    GpuTimer *gpu_timer = nullptr;  // not owned, null without the extension
+
+    uint64_t frame_start = 0;  // ns
+    uint64_t draw_calls_start = 0;
+    uint64_t gpu_ns_start = 0;
+    uint64_t gpu_dropped_start = 0;
+
+    std::vector<double> cpu_ms;
+    std::vector<double> gpu_ms;  // frames spoiled by a disjoint event are left out
+    std::vector<double> finish_ms;
+    std::vector<uint64_t> draw_calls;
+
+    bool enabled() const { return frames > 0; }
+    bool done() const { return static_cast<int>(cpu_ms.size()) >= frames; }
+
+    bool init(int width, int height, GpuTimer *timer);  // needs a current GL context
+    void begin_frame();                                 // binds the FBO
+    void end_frame();                                   // blocks until the GPU is idle
+    void report() const;
+};
+
+// --bench-frames N on the command line, 0 if absent or invalid
+int parse_bench_frames(int argc, char *argv[]);
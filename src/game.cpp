@@ -0,0 +1,177 @@
+#include "game.hpp"
+
+#include <algorithm>
+
+namespace {
+void init_button_layout1(Game &game) {
+    constexpr int cols = 3;
+    constexpr int rows = 4;
+
+    float total_w = (BUTTON_RADIUS * 2) * cols + BUTTON_PADDING * (cols - 1);
+    float total_h = (BUTTON_RADIUS * 2) * rows + BUTTON_PADDING * (rows - 1);
+
+    float xoff = BUTTON_RADIUS + (NORM_WIDTH * 0.5f - total_w) * 0.5f;
+    float yoff = BUTTON_RADIUS + (NORM_HEIGHT - total_h) * 0.5f;
+
+    size_t idx = 0;
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            float x = xoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(j);
+            float y = yoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(i);
+
+            game.button_center[idx] = {x, y};
+            idx++;
+        }
+    }
+
+    // zero
+    float x = xoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(1);
+    float y = yoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(3);
+    game.button_center[9] = {x, y};
+
+    game.text_x = TEXT_LAYOUT1_X;
+    game.text_y = TEXT_LAYOUT1_Y;
+}
+
+void init_button_layout2(Game &game) {
+    constexpr int cols = 5;
+    constexpr int rows = 2;
+
+    float total_w = (BUTTON_RADIUS * 2) * cols + BUTTON_PADDING * (cols - 1);
+    float total_h = (BUTTON_RADIUS * 2) * rows + BUTTON_PADDING * (rows - 1);
+
+    float xoff = BUTTON_RADIUS + (NORM_WIDTH - total_w) * 0.5f;
+    float yoff = BUTTON_RADIUS + NORM_HEIGHT * 0.5f + (NORM_HEIGHT * 0.5f - total_h) * 0.5f;
+
+    size_t idx = 0;
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            float x = xoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(j);
+            float y = yoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(i);
+
+            game.button_center[idx] = {x, y};
+            idx++;
+        }
+    }
+
+    game.text_x = TEXT_LAYOUT2_X;
+    game.text_y = TEXT_LAYOUT2_Y;
+}
+
+void press(Game &game, const glm::vec2 &pos, GameEvents &events) {
+    int hit = hit_test(game.button_center, BUTTON_RADIUS, pos);
+
+    if (hit >= 0) {
+        events.click = true;
+        int num_click = (hit + 1) % 10;
+
+        for (size_t j = 0; j < game.number_done.size(); j++) {
+            if (!game.number_done[j]) {
+                if (num_click == game.number_sequence[j]) {
+                    game.number_done[j] = true;
+                    game.bounce_restart = true;
+                }
+
+                break;
+            }
+        }
+    }
+
+    if (game.won()) {
+        events.win = true;
+        game.delay_left = GAME_DELAY_DURATION_SEC;
+        game.done_count++;
+    }
+}
+
+// Falls from the rest position and bounces back, each bounce lower, restarting every BOUNCE_ANIM_DURATION_SEC
+void update_bounce(Game &game, float dt) {
+    if (game.bounce_restart) {
+        game.bounce_restart = false;
+        game.bounce_time = 0;
+        game.bounce_burst = 0;
+        game.bounce_vel = BOUNCE_ANIM_INITIAL_VEL;
+    } else {
+        game.bounce_time += dt;
+        game.bounce_burst += dt;
+    }
+
+    float u = game.bounce_vel;
+    float a = BOUNCE_ANIM_ACC;
+    float t = game.bounce_time;
+    float d = u * t + a * t * t * 0.5f;
+
+    if (d > 0) {
+        d = 0;
+        game.bounce_vel *= BOUNCE_ANIM_DECAY;
+        game.bounce_time = 0;
+
+        if (game.bounce_burst > BOUNCE_ANIM_DURATION_SEC) {
+            game.bounce_vel = BOUNCE_ANIM_INITIAL_VEL;
+            game.bounce_burst = 0;
+        }
+    }
+
+    game.bounce_offset = d;
+}
+
+}  // namespace
+
+Game::Game(uint32_t seed) : rng(seed) { new_round(); }
+
+GameEvents Game::update(const GameInput &input, float dt) {
+    GameEvents events;
+
+    // presses are ignored while the win sound plays out
+    if (delay_left > 0) {
+        delay_left -= dt;
+
+        if (delay_left <= 0) {
+            delay_left = 0;
+            new_round();
+            events.new_round = true;
+        }
+
+        return events;
+    }
+
+    if (input.press) {
+        press(*this, input.pos, events);
+    }
+
+    update_bounce(*this, dt);
+
+    return events;
+}
+
+void Game::new_round() {
+    std::uniform_int_distribution<> dice(0, 9);
+
+    std::generate(number_sequence.begin(), number_sequence.end(), [&] { return dice(rng); });
+    std::fill(number_done.begin(), number_done.end(), false);
+
+    if (done_count % 2 == 0) {
+        init_button_layout1(*this);
+    } else {
+        init_button_layout2(*this);
+    }
+
+    bounce_restart = true;
+}
+
+bool Game::won() const {
+    return std::all_of(number_done.begin(), number_done.end(), [](bool b) { return b; });
+}
+
+int hit_test(std::span<const glm::vec2> center, float radius, const glm::vec2 &pos) {
+    for (size_t i = 0; i < center.size(); i++) {
+        glm::vec2 start = center[i] - radius;
+        glm::vec2 end = center[i] + radius;
+
+        if ((pos.x > start.x) && (pos.x < end.x) && (pos.y > start.y) && (pos.y < end.y)) {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
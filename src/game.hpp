@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <random>
+#include <span>
+
+// Game rules without SDL or GL, stepped with a fixed timestep so it can be simulated headless.
+// Nothing allocates after construction.
+
+// All co-ordinates used are normalized as follows
+// x: [0.0, 1.0]
+// y: [0.0, 1/ASPECT_RATIO]
+// origin at top-left
+
+constexpr int SEQ_LEN = 4;
+constexpr float ASPECT_RATIO = 16.f / 9.f;
+constexpr float NORM_WIDTH = 1.f;
+constexpr float NORM_HEIGHT = 1.f / ASPECT_RATIO;
+
+constexpr float TEXT_LAYOUT1_X = 0.6f;
+constexpr float TEXT_LAYOUT1_Y = 3.f / 8.f;
+constexpr float TEXT_LAYOUT2_X = 0.35f;
+constexpr float TEXT_LAYOUT2_Y = 0.3f;
+
+constexpr float BUTTON_RADIUS = 0.06f;
+constexpr float BUTTON_PADDING = 0.02f;
+
+constexpr float BOUNCE_ANIM_INITIAL_VEL = -0.25f;
+constexpr float BOUNCE_ANIM_ACC = 1.f;
+constexpr float BOUNCE_ANIM_DECAY = 0.75f;
+constexpr float BOUNCE_ANIM_DURATION_SEC = 2.5f;
+
+constexpr float GAME_DELAY_DURATION_SEC = 1.f;
+
+struct GameInput {
+    bool press = false;  // pointer went down since the last update
+    glm::vec2 pos{};     // where, normalized co-ordinates
+};
+
+// What happened during an update, for sound and anything else outside the rules
+struct GameEvents {
+    bool click = false;      // a button was pressed
+    bool win = false;        // the last digit of the sequence was found
+    bool new_round = false;  // sequence and layout were regenerated
+};
+
+struct Game {
+    std::array<int, SEQ_LEN> number_sequence{};
+    std::array<bool, SEQ_LEN> number_done{};
+    int done_count = 0;  // rounds won, even and odd rounds use different layouts
+
+    std::array<glm::vec2, 10> button_center{};  // button i is digit (i + 1) % 10
+    float text_x = 0;
+    float text_y = 0;
+
+    float delay_left = 0;  // seconds until the next round after a win, 0 while playing
+
+    // bounce of the next digit to find
+    float bounce_offset = 0;  // added to its y
+    float bounce_vel = BOUNCE_ANIM_INITIAL_VEL;
+    float bounce_time = 0;   // since the last landing
+    float bounce_burst = 0;  // since the bounce last restarted at full height
+    bool bounce_restart = true;
+
+    std::mt19937 rng;
+
+    explicit Game(uint32_t seed = 0);
+
+    GameEvents update(const GameInput &input, float dt);
+    void new_round();
+    bool won() const;
+};
+
+// Index of the first square of half size radius around center[i] that contains pos, -1 if none
+int hit_test(std::span<const glm::vec2> center, float radius, const glm::vec2 &pos);
@@ -2,22 +2,31 @@
 
 #include <GLES2/gl2.h>
 
+#include <array>
+#include <cstddef>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "gl_helper.hpp"
 
 namespace {
+// std140, matches FrameUniform and ShapeDrawUniform
 const char *vertex_shader = R"(#version 300 es
 precision mediump float;
 
 layout(location = 0) in vec2 pos; // normalized by drawinga area width
 
-uniform vec2 drawing_area_offset; // screen pixel units
-uniform float scale; // scale to apply on normalized units
-uniform float theta; // rotation in radians
-uniform vec2 trans; // normalized units
-uniform mat4 ortho_matrix;
+layout(std140) uniform Frame {
+    highp mat4 ortho_matrix;
+    highp float display_width;
+};
+
+layout(std140) uniform Draw {
+    highp vec4 color;
+    highp vec2 trans; // normalized units
+    highp float scale; // scale to apply on normalized units
+    highp float theta; // rotation in radians
+};
 
 void main() {
     float c = cos(theta);
@@ -30,13 +39,59 @@ void main() {
 const char *fragment_shader = R"(#version 300 es
 precision mediump float;
 
-uniform vec4 color;
+layout(std140) uniform Draw {
+    highp vec4 color;
+    highp vec2 trans;
+    highp float scale;
+    highp float theta;
+};
+
 out vec4 frag_color;
 
 void main() {
     frag_color = color;
 })";
 
+// Only Draw.color is used, the transform comes from the instance attributes
+const char *instanced_vertex_shader = R"(#version 300 es
+precision mediump float;
+
+layout(location = 0) in vec2 pos; // normalized by drawinga area width
+layout(location = 2) in vec4 transform; // trans.xy, scale, theta
+layout(location = 3) in vec4 tint; // multiplied with the primitive color
+
+layout(std140) uniform Frame {
+    highp mat4 ortho_matrix;
+    highp float display_width;
+};
+
+layout(std140) uniform Draw {
+    highp vec4 color;
+    highp vec2 trans;
+    highp float scale;
+    highp float theta;
+};
+
+flat out vec4 instance_color;
+
+void main() {
+    float c = cos(transform.w);
+    float s = sin(transform.w);
+    mat2 rotation = mat2(c, s, -s, c);
+
+    gl_Position = ortho_matrix * vec4(rotation*pos*transform.z + transform.xy, 0.0, 1.0);
+    instance_color = color * tint;
+})";
+
+const char *instanced_fragment_shader = R"(#version 300 es
+precision mediump float;
+
+flat in vec4 instance_color;
+out vec4 frag_color;
+
+void main() {
+    frag_color = instance_color;
+})";
 }  // namespace
    // :
 std::vector<glm::vec2> make_polygon(int sides, const std::vector<float> &radius) {
@@ -184,16 +239,33 @@ Shape make_shape(const std::vector<glm::vec2> &vert,
 
 bool ShapeShader::init() {
     shader = make_shader(vertex_shader, fragment_shader);
-    if (shader) {
-        return true;
+    if (!shader) {
+        return false;
     }
-    return false;
-}
 
-void ShapeShader::set_ortho(const glm::mat4 &ortho) {
-    assert(shader);
-    shader->use();
-    glUniformMatrix4fv(shader->get_loc("ortho_matrix"), 1, GL_FALSE, glm::value_ptr(ortho));
+    shader->bind_uniform_block("Frame", FRAME_UNIFORM_BINDING);
+    shader->bind_uniform_block("Draw", SHAPE_DRAW_UNIFORM_BINDING);
+
+    instanced_shader = make_shader(instanced_vertex_shader, instanced_fragment_shader);
+    if (!instanced_shader) {
+        return false;
+    }
+
+    instanced_shader->bind_uniform_block("Frame", FRAME_UNIFORM_BINDING);
+    instanced_shader->bind_uniform_block("Draw", SHAPE_DRAW_UNIFORM_BINDING);
+
+    // up to fill, line and line highlight per draw, pushed into a ring
+    draw_uniform = make_uniform_buffer(SHAPE_DRAW_UNIFORM_BINDING, sizeof(ShapeDrawUniform), DRAW_UNIFORM_RING);
+
+    // trans, scale, theta are packed into one vec4
+    std::vector<InstanceAttrib> attrib{
+        {2, 4, offsetof(ShapeInstance, trans)},
+        {3, 4, offsetof(ShapeInstance, color)},
+    };
+
+    instance_buffer = make_instance_buffer(sizeof(ShapeInstance), attrib);
+
+    return true;
 }
 
 glm::vec2 normalize_pos_to_screen_pos(const ShapeShader &shader, const glm::vec2 &pos) {
@@ -204,27 +276,68 @@ glm::vec2 screen_pos_to_normalize_pos(const ShapeShader &shader, const glm::vec2
     return (pos - shader.draw_area_offset) / shader.draw_area_size.x;
 }
 
-void draw_shape(const ShapeShader &shape_shader, const Shape &shape, bool fill, bool line, bool line_highlight) {
-    const ShaderPtr &s = shape_shader.shader;
+namespace {
+// Upload the parameters of every requested primitive in one write, then draw each from its own range
+void draw_primitives(const ShapeShader &shape_shader,
+                     const Shape &shape,
+                     bool fill,
+                     bool line,
+                     bool line_highlight,
+                     const InstanceBufferPtr &optional_inst) {
+    std::array<const ShapePrimitive *, 3> prim;
+    std::array<ShapeDrawUniform, 3> param;
+    size_t n = 0;
+
+    for (auto [enabled, p] : {std::pair{fill, &shape.fill},
+                              std::pair{line, &shape.line},
+                              std::pair{line_highlight, &shape.line_highlight}}) {
+        if (enabled) {
+            prim[n] = p;
+            param[n] = ShapeDrawUniform{p->color, shape.trans, shape.scale, shape.theta};
+            n++;
+        }
+    }
 
-    s->use();
+    if (n == 0) {
+        return;
+    }
 
-    glUniform1f(s->get_loc("scale"), shape.scale);
-    glUniform1f(s->get_loc("theta"), shape.theta);
-    glUniform2fv(s->get_loc("trans"), 1, glm::value_ptr(shape.trans));
+    const UniformBufferPtr &ubo = shape_shader.draw_uniform;
+    size_t first = ubo->push(param.data(), n);
 
-    if (fill) {
-        glUniform4fv(s->get_loc("color"), 1, glm::value_ptr(shape.fill.color));
-        draw_vertex_buffer(s, shape.fill.vertex_buffer);
-    }
+    for (size_t i = 0; i < n; i++) {
+        ubo->bind(first + i);
 
-    if (line) {
-        glUniform4fv(s->get_loc("color"), 1, glm::value_ptr(shape.line.color));
-        draw_vertex_buffer(s, shape.line.vertex_buffer);
+        if (optional_inst) {
+            draw_vertex_buffer_instanced(shape_shader.instanced_shader, prim[i]->vertex_buffer, optional_inst);
+        } else {
+            draw_vertex_buffer(shape_shader.shader, prim[i]->vertex_buffer);
+        }
     }
+}
+}  // namespace
+
+void draw_shape(const ShapeShader &shape_shader, const Shape &shape, bool fill, bool line, bool line_highlight) {
+    draw_primitives(shape_shader, shape, fill, line, line_highlight, {{}, {}});
+}
 
-    if (line_highlight) {
-        glUniform4fv(s->get_loc("color"), 1, glm::value_ptr(shape.line_highlight.color));
-        draw_vertex_buffer(s, shape.line_highlight.vertex_buffer);
+void ShapeBatch::add(const glm::vec2 &trans, float scale, float theta, const glm::vec4 &tint) {
+    instance.push_back(ShapeInstance{trans, scale, theta, tint});
+}
+
+void draw_shape_batch(const ShapeShader &shape_shader,
+                      const Shape &shape,
+                      const ShapeBatch &batch,
+                      bool fill,
+                      bool line,
+                      bool line_highlight) {
+    const InstanceBufferPtr &inst = shape_shader.instance_buffer;
+
+    inst->update(batch.instance.data(), batch.instance.size());
+
+    if (inst->count == 0) {
+        return;
     }
+
+    draw_primitives(shape_shader, shape, fill, line, line_highlight, inst);
 }
@@ -27,13 +27,45 @@ struct Shape {
     float theta = 0.0f;  // rotation in radians
 };
 
+// Per-instance data for draw_shape_batch, matches the instanced shader attributes
+struct ShapeInstance {
+    glm::vec2 trans;
+    float scale;
+    float theta;
+    glm::vec4 color;  // tint, multiplied with the primitive color
+};
+
+// Many copies of the same Shape drawn with one instanced call per primitive.
+// Clear and refill every frame, the vector keeps its capacity.
+struct ShapeBatch {
+    std::vector<ShapeInstance> instance;
+
+    void clear() { instance.clear(); }
+    void add(const glm::vec2 &trans, float scale = 1.0f, float theta = 0.0f, const glm::vec4 &tint = glm::vec4{1.f});
+};
+
+// Per-draw parameters, std140 layout of the Draw uniform block
+struct ShapeDrawUniform {
+    glm::vec4 color;
+    glm::vec2 trans;
+    float scale;
+    float theta;
+};
+
+// Both programs read the shared Frame block (FrameUniform) for the ortho matrix.
 struct ShapeShader {
     ShaderPtr shader{{}, {}};
+
+    // Instanced variant for ShapeBatch, transform comes from the instance buffer.
+    ShaderPtr instanced_shader{{}, {}};
+    InstanceBufferPtr instance_buffer{{}, {}};
+
+    UniformBufferPtr draw_uniform{{}, {}};
+
     glm::vec2 draw_area_offset;
     glm::vec2 draw_area_size;
 
     bool init();
-    void set_ortho(const glm::mat4 &ortho);
 };
 
 struct VertexIndex {
@@ -42,10 +74,17 @@ struct VertexIndex {
 };
 
 void draw_shape(const ShapeShader &shape_shader, const Shape &shape, bool fill, bool line, bool line_highlight);
+void draw_shape_batch(const ShapeShader &shape_shader,
+                      const Shape &shape,
+                      const ShapeBatch &batch,
+                      bool fill,
+                      bool line,
+                      bool line_highlight);
 
 glm::vec2 normalize_pos_to_screen_pos(const ShapeShader &shader, const glm::vec2 &pos);
 glm::vec2 screen_pos_to_normalize_pos(const ShapeShader &shader, const glm::vec2 &pos);
 
+std::vector<glm::vec2> make_polygon(int sides, const std::vector<float> &radius);
 VertexIndex make_fill(const std::vector<glm::vec2> &vert);
 VertexIndex make_line(const std::vector<glm::vec2> &vert, float thickness);
 
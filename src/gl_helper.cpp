@@ -4,8 +4,13 @@
 #include <SDL3/SDL_opengles2.h>
 #include <SDL3/SDL_surface.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "log.hpp"
@@ -36,6 +41,79 @@ bool compile_shader(GLuint s, const char *shader) {
     return true;
 }
 
+bool link_program(GLuint program) {
+    glLinkProgram(program);
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+    if (status == GL_FALSE) {
+        GLint len = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
+
+        std::vector<GLchar> error(static_cast<size_t>(len));
+        glGetProgramInfoLog(program, len, &len, error.data());
+
+        if (len > 0) {
+            LOG("link_program error: %s", error.data());
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+std::map<std::string, UniformInfo> reflect_uniforms(GLuint program) {
+    std::map<std::string, UniformInfo> ret;
+
+    GLint count = 0;
+    GLint max_len = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_len);
+
+    std::vector<GLchar> name(static_cast<size_t>(max_len) + 1);
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei len = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, static_cast<GLuint>(i), max_len, &len, &size, &type, name.data());
+
+        std::string str(name.data(), static_cast<size_t>(len));
+
+        // arrays are reported as "name[0]"
+        if (auto pos = str.find('['); pos != std::string::npos) {
+            str.resize(pos);
+        }
+
+        ret[str] = UniformInfo{glGetUniformLocation(program, name.data()), type};
+    }
+
+    return ret;
+}
+
+// Attribute layout of the currently bound GL_ARRAY_BUFFER, recorded into the bound VAO
+void set_vertex_format(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::POS:
+            gl_state().enable_attrib(0);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+            break;
+
+        case VertexFormat::POS_UV: {
+            int stride = sizeof(float) * 4;
+            int uv_offset = sizeof(float) * 2;
+
+            gl_state().enable_attrib(0);
+            gl_state().enable_attrib(1);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, 0);
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(uv_offset));
+            break;
+        }
+    }
+}
+
 #ifdef __linux__
 void debug_callback(GLenum source,
                     GLenum type,
@@ -60,6 +138,201 @@ void debug_callback(GLenum source,
 
 }  // namespace
 
+GLState &gl_state() {
+    static GLState state;
+    return state;
+}
+
+void GLState::reset() {
+    program = UNKNOWN;
+    active_texture = UNKNOWN;
+    std::fill(std::begin(texture), std::end(texture), UNKNOWN);
+    array_buffer = UNKNOWN;
+    uniform_buffer = UNKNOWN;
+    vertex_array = UNKNOWN;
+    element_buffer = UNKNOWN;
+    attrib_known = 0;
+    attrib_enabled = 0;
+    std::fill(std::begin(uniform_range), std::end(uniform_range), UniformRange{UNKNOWN, 0, 0});
+}
+
+void GLState::use_program(GLuint p) {
+    if (program == p) {
+        skipped++;
+        return;
+    }
+
+    glUseProgram(p);
+    program = p;
+    issued++;
+}
+
+void GLState::bind_texture(GLuint unit, GLuint tex) {
+    assert(unit < MAX_TEXTURE_UNIT);
+
+    if (active_texture != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_texture = unit;
+        issued++;
+    } else {
+        skipped++;
+    }
+
+    if (texture[unit] != tex) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        texture[unit] = tex;
+        issued++;
+    } else {
+        skipped++;
+    }
+}
+
+void GLState::bind_buffer(GLenum target, GLuint buf) {
+    GLuint *cur = &array_buffer;
+
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        cur = &element_buffer;
+    } else if (target == GL_UNIFORM_BUFFER) {
+        cur = &uniform_buffer;
+    }
+
+    if (*cur == buf) {
+        skipped++;
+        return;
+    }
+
+    glBindBuffer(target, buf);
+    *cur = buf;
+    issued++;
+}
+
+void GLState::bind_uniform_range(GLuint binding, GLuint buf, size_t offset, size_t size) {
+    assert(binding < MAX_UNIFORM_BINDING);
+    UniformRange &cur = uniform_range[binding];
+
+    if (cur.buf == buf && cur.offset == offset && cur.size == size) {
+        skipped++;
+        return;
+    }
+
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER, binding, buf, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+    cur = {buf, offset, size};
+
+    // glBindBufferRange also binds the generic binding point
+    uniform_buffer = buf;
+    issued++;
+}
+
+void GLState::bind_vertex_array(GLuint vao) {
+    if (vertex_array == vao) {
+        skipped++;
+        return;
+    }
+
+    glBindVertexArrayOES(vao);
+    vertex_array = vao;
+    element_buffer = UNKNOWN;
+    attrib_known = 0;
+    issued++;
+}
+
+void GLState::enable_attrib(GLuint index) {
+    assert(index < MAX_ATTRIB);
+    uint32_t bit = 1u << index;
+
+    if ((attrib_known & bit) && (attrib_enabled & bit)) {
+        skipped++;
+        return;
+    }
+
+    glEnableVertexAttribArray(index);
+    attrib_known |= bit;
+    attrib_enabled |= bit;
+    issued++;
+}
+
+void GLState::disable_attrib(GLuint index) {
+    assert(index < MAX_ATTRIB);
+    uint32_t bit = 1u << index;
+
+    if ((attrib_known & bit) && !(attrib_enabled & bit)) {
+        skipped++;
+        return;
+    }
+
+    glDisableVertexAttribArray(index);
+    attrib_known |= bit;
+    attrib_enabled &= ~bit;
+    issued++;
+}
+
+void GLState::forget_program(GLuint p) {
+    if (program == p) {
+        program = UNKNOWN;
+    }
+}
+
+void GLState::forget_texture(GLuint tex) {
+    for (auto &t : texture) {
+        if (t == tex) {
+            t = UNKNOWN;
+        }
+    }
+}
+
+void GLState::forget_buffer(GLuint buf) {
+    delete_instanced_vertex_array(0, buf);
+
+    if (array_buffer == buf) {
+        array_buffer = UNKNOWN;
+    }
+
+    if (element_buffer == buf) {
+        element_buffer = UNKNOWN;
+    }
+
+    if (uniform_buffer == buf) {
+        uniform_buffer = UNKNOWN;
+    }
+
+    for (auto &r : uniform_range) {
+        if (r.buf == buf) {
+            r.buf = UNKNOWN;
+        }
+    }
+}
+
+void GLState::forget_vertex_array(GLuint vao) {
+    delete_instanced_vertex_array(vao, 0);
+
+    if (vertex_array == vao) {
+        vertex_array = UNKNOWN;
+        element_buffer = UNKNOWN;
+        attrib_known = 0;
+    }
+}
+
+void GLState::delete_instanced_vertex_array(GLuint mesh, GLuint instance) {
+    auto &iva = instanced_vertex_array;
+
+    for (auto it = iva.begin(); it != iva.end();) {
+        if ((mesh == 0 || it->mesh != mesh) && (instance == 0 || it->instance != instance)) {
+            it++;
+            continue;
+        }
+
+        if (vertex_array == it->vao) {
+            vertex_array = UNKNOWN;
+            element_buffer = UNKNOWN;
+            attrib_known = 0;
+        }
+
+        glDeleteVertexArraysOES(1, &it->vao);
+        it = iva.erase(it);
+    }
+}
+
 void enable_gl_debug_callback() {
 #ifdef __linux__
     glEnable(GL_DEBUG_OUTPUT_KHR);
@@ -67,27 +340,66 @@ void enable_gl_debug_callback() {
 #endif
 }
 
-void VertexArray::use() { glBindVertexArrayOES(vao); }
+void Shader::use() const { gl_state().use_program(program); }
 
-VertexArrayPtr make_vertex_array() {
-    auto cleanup = [](VertexArray *v) {
-        LOG("deleting vertex array: %d", v->vao);
-        glDeleteVertexArraysOES(1, &v->vao);
-    };
+GLint Shader::get_loc(const char *name, GLenum type) const {
+    auto it = uniform_info.find(name);
 
-    VertexArrayPtr v(new VertexArray, cleanup);
+    if (it == uniform_info.end()) {
+        // Not necessarily an error, the compiler strips unused uniforms.
+        LOG("uniform '%s' is not active in program %d", name, program);
+        return -1;
+    }
 
-    glGenVertexArraysOES(1, &v->vao);
+    const UniformInfo &u = it->second;
 
-    return v;
+    // samplers are set as int
+    bool sampler = (type == GL_INT) && (u.type == GL_SAMPLER_2D);
+
+    if (u.type != type && !sampler) {
+        LOG("uniform '%s' type mismatch: expected 0x%x, got 0x%x", name, type, u.type);
+        return -1;
+    }
+
+    return u.loc;
 }
 
-void Shader::use() const { glUseProgram(program); }
+bool Shader::bind_uniform_block(const char *block_name, GLuint binding) const {
+    GLuint idx = glGetUniformBlockIndex(program, block_name);
 
-GLint Shader::get_loc(const char *name) const {
-    GLint ret = glGetUniformLocation(program, name);
-    // assert(ret >= 0);
-    return ret;
+    if (idx == GL_INVALID_INDEX) {
+        LOG("uniform block '%s' is not active in program %d", block_name, program);
+        return false;
+    }
+
+    glUniformBlockBinding(program, idx, binding);
+
+    return true;
+}
+
+template <>
+void Uniform<int>::set(const int &value) const {
+    glUniform1i(loc, value);
+}
+
+template <>
+void Uniform<float>::set(const float &value) const {
+    glUniform1f(loc, value);
+}
+
+template <>
+void Uniform<glm::vec2>::set(const glm::vec2 &value) const {
+    glUniform2fv(loc, 1, glm::value_ptr(value));
+}
+
+template <>
+void Uniform<glm::vec4>::set(const glm::vec4 &value) const {
+    glUniform4fv(loc, 1, glm::value_ptr(value));
+}
+
+template <>
+void Uniform<glm::mat4>::set(const glm::mat4 &value) const {
+    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 ShaderPtr make_shader(const char *vertex_code, const char *fragment_code) {
@@ -95,6 +407,7 @@ ShaderPtr make_shader(const char *vertex_code, const char *fragment_code) {
         LOG("deleting shader: %d %d %d", s->program, s->vertex, s->fragment);
         glDeleteShader(s->vertex);
         glDeleteShader(s->fragment);
+        gl_state().forget_program(s->program);
         glDeleteProgram(s->program);
     };
 
@@ -116,7 +429,13 @@ ShaderPtr make_shader(const char *vertex_code, const char *fragment_code) {
 
     glAttachShader(s->program, s->vertex);
     glAttachShader(s->program, s->fragment);
-    glLinkProgram(s->program);
+
+    if (!link_program(s->program)) {
+        LOG("failed to link shader program");
+        return {{}, cleanup};
+    }
+
+    s->uniform_info = reflect_uniforms(s->program);
 
     return s;
 }
@@ -128,83 +447,143 @@ TexturePtr make_texture(const std::string &bmp_path) {
         return {{}, {}};
     }
 
+    // SDL pads rows to 4 bytes, same as the default GL_UNPACK_ALIGNMENT
+    TexturePtr t = make_texture(bmp->w, bmp->h, static_cast<const uint8_t *>(bmp->pixels), 4);
+
+    SDL_DestroySurface(bmp);
+
+    return t;
+}
+
+TexturePtr make_texture(int width, int height, const uint8_t *rgb, int row_alignment) {
     auto cleanup = [](Texture *t) {
         LOG("deleting texture: %d(%dx%d)", t->id, t->width, t->height);
+        gl_state().forget_texture(t->id);
         glDeleteTextures(1, &t->id);
     };
 
     TexturePtr t(new Texture, cleanup);
 
-    t->width = bmp->w;
-    t->height = bmp->h;
+    t->width = width;
+    t->height = height;
 
     glGenTextures(1, &t->id);
-    glBindTexture(GL_TEXTURE_2D, t->id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, bmp->w, bmp->h, 0, GL_RGB, GL_UNSIGNED_BYTE, bmp->pixels);
+    gl_state().bind_texture(0, t->id);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, row_alignment);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    SDL_DestroySurface(bmp);
-
     return t;
 }
 
-void Texture::use() const {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, id);
+void Texture::use() const { gl_state().bind_texture(0, id); }
+
+FramebufferPtr make_framebuffer(int width, int height) {
+    auto cleanup = [](Framebuffer *f) {
+        LOG("deleting framebuffer: %d(%dx%d)", f->id, f->width, f->height);
+        glDeleteFramebuffers(1, &f->id);
+        glDeleteRenderbuffers(1, &f->color);
+    };
+
+    FramebufferPtr f(new Framebuffer, cleanup);
+
+    f->width = width;
+    f->height = height;
+
+    glGenRenderbuffers(1, &f->color);
+    glBindRenderbuffer(GL_RENDERBUFFER, f->color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenFramebuffers(1, &f->id);
+    glBindFramebuffer(GL_FRAMEBUFFER, f->id);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, f->color);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG("framebuffer incomplete: 0x%x", status);
+        return {{}, {}};
+    }
+
+    return f;
 }
 
+void Framebuffer::use() const { glBindFramebuffer(GL_FRAMEBUFFER, id); }
+
 VertexBufferPtr make_vertex_buffer(const std::vector<glm::vec2> &vertex, const std::vector<uint32_t> &index) {
-    return make_vertex_buffer(glm::value_ptr(vertex[0]), sizeof(glm::vec2) * vertex.size(), index);
+    return make_vertex_buffer(glm::value_ptr(vertex[0]), sizeof(glm::vec2) * vertex.size(), index, VertexFormat::POS);
 }
 
 VertexBufferPtr make_vertex_buffer(const std::vector<glm::vec4> &vertex, const std::vector<uint32_t> &index) {
-    return make_vertex_buffer(glm::value_ptr(vertex[0]), sizeof(glm::vec4) * vertex.size(), index);
+    return make_vertex_buffer(
+        glm::value_ptr(vertex[0]), sizeof(glm::vec4) * vertex.size(), index, VertexFormat::POS_UV);
 }
 
-VertexBufferPtr make_vertex_buffer(const float *vertex, size_t vertex_bytes, const std::vector<uint32_t> &index) {
+VertexBufferPtr make_vertex_buffer(const float *vertex,
+                                   size_t vertex_bytes,
+                                   const std::vector<uint32_t> &index,
+                                   VertexFormat format) {
     auto cleanup = [](VertexBuffer *v) {
         LOG("deleting vertex and index buffer: %d(%d bytes) %d(%d count)",
             v->vertex,
             static_cast<int>(v->vertex_bytes),
             v->index,
             static_cast<int>(v->index_count));
+        gl_state().forget_vertex_array(v->vao);
+        gl_state().forget_buffer(v->vertex);
+        gl_state().forget_buffer(v->index);
+        glDeleteVertexArraysOES(1, &v->vao);
         glDeleteBuffers(1, &v->vertex);
         glDeleteBuffers(1, &v->index);
     };
 
     VertexBufferPtr v(new VertexBuffer, cleanup);
 
+    v->format = format;
+
+    // VAO first, the element buffer binding below is recorded into it
+    glGenVertexArraysOES(1, &v->vao);
+    gl_state().bind_vertex_array(v->vao);
+
     glGenBuffers(1, &v->vertex);
-    glBindBuffer(GL_ARRAY_BUFFER, v->vertex);
+    gl_state().bind_buffer(GL_ARRAY_BUFFER, v->vertex);
     glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertex_bytes), vertex, GL_DYNAMIC_DRAW);
     v->vertex_bytes = vertex_bytes;
 
     glGenBuffers(1, &v->index);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, v->index);
+    gl_state().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, v->index);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
                  static_cast<GLsizeiptr>(sizeof(uint32_t) * index.size()),
                  index.data(),
                  GL_STATIC_DRAW);
     v->index_count = index.size();
 
+    set_vertex_format(format);
+
     return v;
 }
 
-void VertexBuffer::use() const {
-    glBindBuffer(GL_ARRAY_BUFFER, vertex);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index);
-}
+void VertexBuffer::use() const { gl_state().bind_vertex_array(vao); }
 
 void VertexBuffer::update_vertex(const float *v, size_t v_bytes, const std::vector<uint32_t> &optional_idx) {
-    glBindBuffer(GL_ARRAY_BUFFER, vertex);
+    gl_state().bind_buffer(GL_ARRAY_BUFFER, vertex);
     glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(v_bytes), v);
 
     if (!optional_idx.empty()) {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(optional_idx.size()), optional_idx.data());
+        // element buffer binding belongs to the VAO
+        use();
+        gl_state().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, index);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                        0,
+                        static_cast<GLsizeiptr>(sizeof(uint32_t) * optional_idx.size()),
+                        optional_idx.data());
         index_count = optional_idx.size();
     }
 }
@@ -214,25 +593,183 @@ void draw_vertex_buffer(const ShaderPtr &shader, const VertexBufferPtr &v, const
 
     if (optional_tex) {
         optional_tex->use();
+    }
 
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
+    v->use();
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(v->index_count), GL_UNSIGNED_INT, 0);
+    gl_state().draw_calls++;
+}
 
-        int stride = sizeof(float) * 4;
-        int uv_offset = sizeof(float) * 2;
+InstanceBufferPtr make_instance_buffer(size_t stride, const std::vector<InstanceAttrib> &attrib) {
+    auto cleanup = [](InstanceBuffer *b) {
+        LOG("deleting instance buffer: %d(%d bytes)", b->id, static_cast<int>(b->capacity));
+        gl_state().forget_buffer(b->id);  // also deletes its instanced VAOs
+        glDeleteBuffers(1, &b->id);
+    };
 
-        v->use();
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, 0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(uv_offset));
-    } else {
-        glEnableVertexAttribArray(0);
-        v->use();
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    InstanceBufferPtr b(new InstanceBuffer, cleanup);
+
+    glGenBuffers(1, &b->id);
+    b->stride = stride;
+    b->attrib = attrib;
+
+    return b;
+}
+
+void InstanceBuffer::update(const void *data, size_t instance_count) {
+    size_t bytes = stride * instance_count;
+
+    gl_state().bind_buffer(GL_ARRAY_BUFFER, id);
+
+    if (bytes > capacity) {
+        capacity = std::max(bytes, capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
     }
 
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(v->index_count), GL_UNSIGNED_INT, 0);
+    if (bytes > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), data);
+    }
+
+    count = instance_count;
+}
+
+void InstanceBuffer::use(const VertexBuffer &v) {
+    for (const auto &iva : gl_state().instanced_vertex_array) {
+        if (iva.mesh == v.vao && iva.instance == id) {
+            gl_state().bind_vertex_array(iva.vao);
+            return;
+        }
+    }
+
+    // First time with this mesh, record mesh + instance attributes into a new VAO.
+    // The buffer id never changes when it grows so the VAO stays valid.
+    GLuint vao = 0;
+    glGenVertexArraysOES(1, &vao);
+    gl_state().bind_vertex_array(vao);
+
+    gl_state().bind_buffer(GL_ARRAY_BUFFER, v.vertex);
+    gl_state().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, v.index);
+    set_vertex_format(v.format);
+
+    gl_state().bind_buffer(GL_ARRAY_BUFFER, id);
+
+    for (const auto &a : attrib) {
+        gl_state().enable_attrib(a.location);
+        glVertexAttribPointer(a.location,
+                              a.size,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              static_cast<GLsizei>(stride),
+                              reinterpret_cast<void *>(a.offset));
+        glVertexAttribDivisor(a.location, 1);
+    }
+
+    gl_state().instanced_vertex_array.push_back({v.vao, id, vao});
+}
+
+void draw_vertex_buffer_instanced(const ShaderPtr &shader,
+                                  const VertexBufferPtr &v,
+                                  const InstanceBufferPtr &inst,
+                                  const TexturePtr &optional_tex) {
+    if (inst->count == 0) {
+        return;
+    }
+
+    shader->use();
+
+    if (optional_tex) {
+        optional_tex->use();
+    }
+
+    inst->use(*v);
+    glDrawElementsInstanced(GL_TRIANGLES,
+                            static_cast<GLsizei>(v->index_count),
+                            GL_UNSIGNED_INT,
+                            0,
+                            static_cast<GLsizei>(inst->count));
+    gl_state().draw_calls++;
 }
 
+UniformBufferPtr make_uniform_buffer(GLuint binding, size_t entry_bytes, size_t capacity) {
+    auto cleanup = [](UniformBuffer *b) {
+        LOG("deleting uniform buffer: %d(binding %d, %d bytes)",
+            b->id,
+            b->binding,
+            static_cast<int>(b->stride * b->capacity));
+        gl_state().forget_buffer(b->id);
+        glDeleteBuffers(1, &b->id);
+    };
+
+    UniformBufferPtr b(new UniformBuffer, cleanup);
+
+    GLint align = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    size_t a = static_cast<size_t>(std::max(align, 1));
+
+    b->binding = binding;
+    b->entry_bytes = entry_bytes;
+    b->stride = (entry_bytes + a - 1) / a * a;
+    b->capacity = capacity;
+    b->staging.resize(b->stride * capacity);
+
+    glGenBuffers(1, &b->id);
+    gl_state().bind_buffer(GL_UNIFORM_BUFFER, b->id);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(b->staging.size()), nullptr, GL_DYNAMIC_DRAW);
+
+    b->bind(0);
+
+    return b;
+}
+
+void UniformBuffer::update(const void *data, size_t count) {
+    assert(count <= capacity);
+
+    gl_state().bind_buffer(GL_UNIFORM_BUFFER, id);
+
+    if (count == 1) {
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(entry_bytes), data);
+        return;
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(data);
+
+    for (size_t i = 0; i < count; i++) {
+        memcpy(staging.data() + i * stride, src + i * entry_bytes, entry_bytes);
+    }
+
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(stride * (count - 1) + entry_bytes), staging.data());
+}
+
+size_t UniformBuffer::push(const void *data, size_t count) {
+    assert(count > 0 && count <= capacity);
+
+    gl_state().bind_buffer(GL_UNIFORM_BUFFER, id);
+
+    if (head + count > capacity) {
+        // fresh storage, the driver keeps the old one alive for draws still in flight
+        glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(staging.size()), nullptr, GL_DYNAMIC_DRAW);
+        head = 0;
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(data);
+
+    for (size_t i = 0; i < count; i++) {
+        memcpy(staging.data() + i * stride, src + i * entry_bytes, entry_bytes);
+    }
+
+    glBufferSubData(GL_UNIFORM_BUFFER,
+                    static_cast<GLintptr>(head * stride),
+                    static_cast<GLsizeiptr>(stride * (count - 1) + entry_bytes),
+                    staging.data());
+
+    size_t first = head;
+    head += count;
+
+    return first;
+}
+
+void UniformBuffer::bind(size_t i) const { gl_state().bind_uniform_range(binding, id, i * stride, entry_bytes); }
+
 std::pair<glm::vec2, glm::vec2> bbox(const std::vector<glm::vec4> &vertex) {
     float x0 = vertex[0].x;
     float x1 = vertex[0].x;
@@ -2,36 +2,208 @@
 
 #define GL_GLEXT_PROTOTYPES
 #include <SDL3/SDL_opengles2.h>
+// GLES 3.0 entry points (instancing), we already ask for a 3.0 context
+#include <GLES3/gl3.h>
 
+#include <cstdint>
+#include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+// Shadow copy of the GL bindings we touch so redundant calls never reach the driver.
+// All binds in gl_helper go through here. Call reset() if GL state is changed behind its back.
+struct GLState {
+    static constexpr GLuint UNKNOWN = 0xffffffff;
+    static constexpr size_t MAX_TEXTURE_UNIT = 8;
+    static constexpr size_t MAX_ATTRIB = 32;
+
+    GLuint program = UNKNOWN;
+    GLuint active_texture = UNKNOWN;  // unit index, not GL_TEXTURE0 + n
+    GLuint texture[MAX_TEXTURE_UNIT];
+    GLuint array_buffer = UNKNOWN;
+    GLuint uniform_buffer = UNKNOWN;
+    GLuint vertex_array = UNKNOWN;
+
+    // glBindBufferRange(GL_UNIFORM_BUFFER, ...) per binding point
+    static constexpr size_t MAX_UNIFORM_BINDING = 8;
+    struct UniformRange {
+        GLuint buf;
+        size_t offset;
+        size_t size;
+    };
+    UniformRange uniform_range[MAX_UNIFORM_BINDING];
+
+    // vertex array state, forgotten when the vertex array changes
+    GLuint element_buffer = UNKNOWN;
+    uint32_t attrib_known = 0;  // bitmask
+    uint32_t attrib_enabled = 0;
+
+    // VAOs pairing a mesh with an instance buffer, built by InstanceBuffer::use.
+    // Owned here so deleting either side deletes the pair before GL hands the name out again.
+    struct InstancedVertexArray {
+        GLuint mesh;      // VertexBuffer::vao
+        GLuint instance;  // InstanceBuffer::id
+        GLuint vao;
+    };
+    std::vector<InstancedVertexArray> instanced_vertex_array;
+
+    uint64_t issued = 0;
+    uint64_t skipped = 0;
+    uint64_t draw_calls = 0;  // glDraw* issued through gl_helper
+
+    GLState() { reset(); }
+
+    void reset();
+
+    void use_program(GLuint p);
+    void bind_texture(GLuint unit, GLuint tex);  // GL_TEXTURE_2D
+    void bind_buffer(GLenum target, GLuint buf);
+    void bind_uniform_range(GLuint binding, GLuint buf, size_t offset, size_t size);
+    void bind_vertex_array(GLuint vao);
+    void enable_attrib(GLuint index);
+    void disable_attrib(GLuint index);
+
+    // Deleted names can be handed out again by glGen*, so forget them.
+    // Buffers and vertex arrays also delete any instanced VAO built from them.
+    void forget_program(GLuint p);
+    void forget_texture(GLuint tex);
+    void forget_buffer(GLuint buf);
+    void forget_vertex_array(GLuint vao);
+
+    // Delete the instanced VAOs built from mesh or instance, 0 matches neither
+    void delete_instanced_vertex_array(GLuint mesh, GLuint instance);
+};
+
+// Global state cache for the (single) GL context
+GLState &gl_state();
+
 // Light wrapper around common OpenGL types.
 // The unique_ptr will delete the OpenGL object automatically.
 
-struct VertexArray {
-    GLuint vao;
-    void use();
+// Pre-resolved uniform location, typed by the value it accepts.
+// Setting it is a single glUniform* call, the program must already be in use.
+template <typename T>
+struct Uniform {
+    GLint loc = -1;
+
+    void set(const T &value) const;
 };
 
-using VertexArrayPtr = std::unique_ptr<VertexArray, void (*)(VertexArray *)>;
-VertexArrayPtr make_vertex_array();
+template <>
+void Uniform<int>::set(const int &value) const;
+template <>
+void Uniform<float>::set(const float &value) const;
+template <>
+void Uniform<glm::vec2>::set(const glm::vec2 &value) const;
+template <>
+void Uniform<glm::vec4>::set(const glm::vec4 &value) const;
+template <>
+void Uniform<glm::mat4>::set(const glm::mat4 &value) const;
+
+template <typename T>
+constexpr GLenum uniform_gl_type();
+template <>
+constexpr GLenum uniform_gl_type<int>() {
+    return GL_INT;
+}
+template <>
+constexpr GLenum uniform_gl_type<float>() {
+    return GL_FLOAT;
+}
+template <>
+constexpr GLenum uniform_gl_type<glm::vec2>() {
+    return GL_FLOAT_VEC2;
+}
+template <>
+constexpr GLenum uniform_gl_type<glm::vec4>() {
+    return GL_FLOAT_VEC4;
+}
+template <>
+constexpr GLenum uniform_gl_type<glm::mat4>() {
+    return GL_FLOAT_MAT4;
+}
+
+struct UniformInfo {
+    GLint loc = -1;
+    GLenum type = 0;  // GL_FLOAT, GL_FLOAT_VEC2 ...
+};
 
 struct Shader {
     GLuint program = 0;
     GLuint vertex = 0;
     GLuint fragment = 0;
 
-    void use() const;                       // glUseProgram
-    GLint get_loc(const char *name) const;  // glGetUniformLocation
+    // Active uniforms, reflected once after linking
+    std::map<std::string, UniformInfo> uniform_info;
+
+    void use() const;  // glUseProgram
+
+    // Attach a std140 uniform block to a binding point, see UniformBuffer
+    bool bind_uniform_block(const char *block_name, GLuint binding) const;
+
+    // Registry lookup, returns -1 if the uniform is not active or the type does not match.
+    // Resolve once at init and keep the Uniform<T> around, don't call this per frame.
+    GLint get_loc(const char *name, GLenum type) const;
+
+    template <typename T>
+    Uniform<T> get_uniform(const char *name) const {
+        return {get_loc(name, uniform_gl_type<T>())};
+    }
 };
 
 using ShaderPtr = std::unique_ptr<Shader, void (*)(Shader *)>;
 ShaderPtr make_shader(const char *vertex_code, const char *fragment_code);
 
+// Uniform block binding points, fixed so programs can share buffers
+constexpr GLuint FRAME_UNIFORM_BINDING = 0;
+constexpr GLuint SHAPE_DRAW_UNIFORM_BINDING = 1;
+constexpr GLuint FONT_DRAW_UNIFORM_BINDING = 2;
+
+// Entries in the per-draw uniform rings (UniformBuffer::push), several frames of draws between orphans
+constexpr size_t DRAW_UNIFORM_RING = 64;
+
+// Per-frame parameters shared by every program, std140 layout of
+//
+// layout(std140) uniform Frame {
+//     highp mat4 ortho_matrix;
+//     highp float display_width;
+// };
+struct FrameUniform {
+    glm::mat4 ortho_matrix;
+    float display_width;
+    float pad[3];
+};
+
+// Buffer backing a std140 uniform block. Holds one or more entries of entry_bytes each,
+// spaced by the GL offset alignment so each can be bound on its own with bind(i).
+// update() rewrites entries from 0, for data set rarely like the Frame block.
+// push() is for per-draw data, see below.
+struct UniformBuffer {
+    GLuint id = 0;
+    GLuint binding = 0;
+    size_t entry_bytes = 0;
+    size_t stride = 0;    // entry_bytes rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t capacity = 0;  // entries
+    size_t head = 0;      // next entry written by push
+    std::vector<uint8_t> staging;
+
+    void update(const void *data, size_t count = 1);
+
+    // Write count entries after the last push with a single upload and return the index of the first.
+    // Draws already queued keep reading their own entries, nothing is overwritten in place.
+    // When the buffer is full it is orphaned and writing restarts at 0, so size it for a few frames.
+    size_t push(const void *data, size_t count = 1);
+
+    void bind(size_t i = 0) const;
+};
+
+using UniformBufferPtr = std::unique_ptr<UniformBuffer, void (*)(UniformBuffer *)>;
+UniformBufferPtr make_uniform_buffer(GLuint binding, size_t entry_bytes, size_t capacity = 1);
+
 struct Texture {
     GLuint id = 0;
     int width = 0;
@@ -42,14 +214,35 @@ struct Texture {
 
 using TexturePtr = std::unique_ptr<Texture, void (*)(Texture *)>;
 TexturePtr make_texture(const std::string &bmp_path);
+TexturePtr make_texture(int width, int height, const uint8_t *rgb, int row_alignment);  // 8 bit RGB
+
+// Offscreen render target with a single RGBA8 color renderbuffer
+struct Framebuffer {
+    GLuint id = 0;
+    GLuint color = 0;
+    int width = 0;
+    int height = 0;
+
+    void use() const;  // glBindFramebuffer, 0 restores the default framebuffer
+};
+
+using FramebufferPtr = std::unique_ptr<Framebuffer, void (*)(Framebuffer *)>;
+FramebufferPtr make_framebuffer(int width, int height);
 
 // This is general enough to represent all the drawing combos we need.
 // - vertex only
 // - vertex + texture uv
-// - vertex + color
+enum class VertexFormat {
+    POS,     // vec2 at location 0
+    POS_UV,  // vec2 at location 0, vec2 at location 1, interleaved
+};
+
+// Owns a VAO with the attribute layout recorded once at creation, drawing is bind VAO + draw.
 struct VertexBuffer {
+    GLuint vao = 0;
     GLuint vertex = 0;
     GLuint index = 0;
+    VertexFormat format = VertexFormat::POS;
 
     size_t vertex_bytes = 0;
     size_t index_count = 0;
@@ -65,10 +258,41 @@ using VertexBufferPtr = std::unique_ptr<VertexBuffer, void (*)(VertexBuffer *)>;
 VertexBufferPtr make_vertex_buffer(const std::vector<glm::vec2> &vertex, const std::vector<uint32_t> &index);
 VertexBufferPtr make_vertex_buffer(const std::vector<glm::vec4> &vertex,
                                    const std::vector<uint32_t> &index);  // pos + texture uv
-VertexBufferPtr make_vertex_buffer(const float *vertex, size_t vertex_bytes, const std::vector<uint32_t> &index);
+VertexBufferPtr make_vertex_buffer(const float *vertex,
+                                   size_t vertex_bytes,
+                                   const std::vector<uint32_t> &index,
+                                   VertexFormat format);
 
 void draw_vertex_buffer(const ShaderPtr &shader, const VertexBufferPtr &v, const TexturePtr &optional_tex = {{}, {}});
 
+// Per-instance vertex attribute, read with a divisor of 1
+struct InstanceAttrib {
+    GLuint location;
+    GLint size;  // number of floats
+    size_t offset;
+};
+
+// Streamed buffer of per-instance data, grows as needed and is reused across frames.
+struct InstanceBuffer {
+    GLuint id = 0;
+    size_t capacity = 0;  // bytes
+    size_t stride = 0;
+    size_t count = 0;  // instances uploaded by the last update
+    std::vector<InstanceAttrib> attrib;
+
+    void update(const void *data, size_t instance_count);
+    void use(const VertexBuffer &v);  // bind the VAO for v + instances, see GLState::instanced_vertex_array
+};
+
+using InstanceBufferPtr = std::unique_ptr<InstanceBuffer, void (*)(InstanceBuffer *)>;
+InstanceBufferPtr make_instance_buffer(size_t stride, const std::vector<InstanceAttrib> &attrib);
+
+// Draw v once per instance in inst. v is vertex only (vec2), any per-instance data comes from inst.
+void draw_vertex_buffer_instanced(const ShaderPtr &shader,
+                                  const VertexBufferPtr &v,
+                                  const InstanceBufferPtr &inst,
+                                  const TexturePtr &optional_tex = {{}, {}});
+
 struct BBox {
     glm::vec2 start;
     glm::vec2 end;
@@ -0,0 +1,131 @@
+#include "gpu_timer.hpp"
+
+#include <SDL3/SDL.h>
+
+#include "log.hpp"
+
+namespace {
+// Extension entry points, not exported by every GLES library so always looked up
+PFNGLGENQUERIESEXTPROC gen_queries;
+PFNGLDELETEQUERIESEXTPROC delete_queries;
+PFNGLBEGINQUERYEXTPROC begin_query;
+PFNGLENDQUERYEXTPROC end_query;
+PFNGLGETQUERYOBJECTUIVEXTPROC get_query_uiv;
+PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v;
+
+template <typename T>
+bool load_proc(T &fn, const char *name) {
+    fn = reinterpret_cast<T>(SDL_GL_GetProcAddress(name));
+    return fn != nullptr;
+}
+
+}  // namespace
+
+void GpuTimer::begin(Zone zone) {
+    if (active || write - read == POOL) {
+        return;
+    }
+
+    Query &q = query[write % POOL];
+    q.zone = zone;
+    q.frame = profiler().frame;
+    q.issued = SDL_GetTicksNS();
+
+    begin_query(GL_TIME_ELAPSED_EXT, q.id);
+    active = true;
+}
+
+void GpuTimer::end() {
+    if (!active) {
+        return;
+    }
+
+    end_query(GL_TIME_ELAPSED_EXT);
+    write++;
+    active = false;
+}
+
+void GpuTimer::collect() {
+    // queries finish in order, stop at the first one still running
+    uint64_t ready = read;
+
+    while (ready < write) {
+        GLuint available = 0;
+        get_query_uiv(query[ready % POOL].id, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available) {
+            break;
+        }
+
+        ready++;
+    }
+
+    // Checked after availability so a query that finished just now is still covered.
+    // Reading the flag clears it, and a disjoint event (clock change, context loss) spoils every query issued
+    // so far, including the ones still in flight that would otherwise be collected on a later frame.
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    if (disjoint) {
+        valid_from = active ? write + 1 : write;
+    }
+
+    for (; read < ready; read++) {
+        if (read < valid_from) {
+            dropped++;
+            continue;
+        }
+
+        const Query &q = query[read % POOL];
+
+        GLuint64 ns = 0;
+        get_query_ui64v(q.id, GL_QUERY_RESULT_EXT, &ns);
+
+        profiler().record(q.zone, q.issued, q.issued + ns, q.frame);
+        recorded_ns += ns;
+    }
+}
+
+GpuTimerPtr make_gpu_timer() {
+    auto cleanup = [](GpuTimer *t) {
+        for (auto &q : t->query) {
+            delete_queries(1, &q.id);
+        }
+        delete t;
+    };
+
+    if (!SDL_GL_ExtensionSupported("GL_EXT_disjoint_timer_query")) {
+        LOG("GL_EXT_disjoint_timer_query not supported, no GPU timing");
+        return {{}, {}};
+    }
+
+    bool ok = load_proc(gen_queries, "glGenQueriesEXT") && load_proc(delete_queries, "glDeleteQueriesEXT") &&
+              load_proc(begin_query, "glBeginQueryEXT") && load_proc(end_query, "glEndQueryEXT") &&
+              load_proc(get_query_uiv, "glGetQueryObjectuivEXT") &&
+              load_proc(get_query_ui64v, "glGetQueryObjectui64vEXT");
+
+    if (!ok) {
+        LOG("GL_EXT_disjoint_timer_query entry points missing, no GPU timing");
+        return {{}, {}};
+    }
+
+    GpuTimerPtr t(new GpuTimer, cleanup);
+
+    for (auto &q : t->query) {
+        gen_queries(1, &q.id);
+    }
+
+    return t;
+}
+
+ScopedGpuTimer::ScopedGpuTimer(const GpuTimerPtr &t, Zone zone) : timer(t.get()), started(false) {
+    if (timer) {
+        timer->begin(zone);
+        started = timer->active;
+    }
+}
+
+ScopedGpuTimer::~ScopedGpuTimer() {
+    if (started) {
+        timer->end();
+    }
+}
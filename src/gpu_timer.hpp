@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "gl_helper.hpp"
+#include "profiler.hpp"
+
+// GPU time of render passes with GL_EXT_disjoint_timer_query.
+// Results are read back a few frames later once available, so the CPU never waits on the GPU.
+// Finished passes are recorded into the profiler under the zone they were started with.
+struct GpuTimer {
+    static constexpr size_t POOL = 32;  // queries in flight, a handful of frames worth of passes
+
+    struct Query {
+        GLuint id = 0;
+        Zone zone = Zone::FRAME;
+        uint32_t frame = 0;
+        uint64_t issued = 0;  // CPU ns, start of the recorded sample
+    };
+
+    std::array<Query, POOL> query;
+    uint64_t write = 0;       // queries started
+    uint64_t read = 0;        // queries collected
+    uint64_t valid_from = 0;  // queries issued before the last disjoint event are dropped
+    bool active = false;
+
+    // Running totals for callers that want per-frame GPU time, e.g. FrameBench
+    uint64_t recorded_ns = 0;  // sum of every recorded query
+    uint64_t dropped = 0;      // queries thrown away after a disjoint event
+
+    // Timer queries can't nest, begin is ignored while one is running or the pool is full
+    void begin(Zone zone);
+    void end();
+
+    // Record every finished query, call once per frame
+    void collect();
+};
+
+using GpuTimerPtr = std::unique_ptr<GpuTimer, void (*)(GpuTimer *)>;
+
+// Null when the driver doesn't have the extension, needs a current GL context
+GpuTimerPtr make_gpu_timer();
+
+// Times the enclosing scope on the GPU, timer can be null
+struct ScopedGpuTimer {
+    GpuTimer *timer;
+    bool started;
+
+    ScopedGpuTimer(const GpuTimerPtr &t, Zone zone);
+    ~ScopedGpuTimer();
+
+    ScopedGpuTimer(const ScopedGpuTimer &) = delete;
+    ScopedGpuTimer &operator=(const ScopedGpuTimer &) = delete;
+};
@@ -9,44 +9,38 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <future>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <map>
 #include <optional>
 #include <random>
+#include <string>
 #include <vector>
 
 #include "audio.hpp"
+#include "audio_cache.hpp"
 #include "color_palette.hpp"
 #include "font.hpp"
+#include "frame_bench.hpp"
+#include "game.hpp"
 #include "geometry.hpp"
 #include "gl_helper.hpp"
+#include "gpu_timer.hpp"
 #include "log.hpp"
+#include "mixer.hpp"
+#include "profiler.hpp"
 
-// All co-ordinates used are normalized as follows
-// x: [0.0, 1.0]
-// y: [0.0, 1/ASPECT_RATIO]
-// origin at top-left
-
-constexpr int SEQ_LEN = 4;
-constexpr float ASPECT_RATIO = 16.f / 9.f;
-constexpr float NORM_WIDTH = 1.f;
-constexpr float NORM_HEIGHT = 1.f / ASPECT_RATIO;
+// Co-ordinates are normalized, see game.hpp
 
 constexpr glm::vec4 BG_COLOR = Color::darkgrey;
 
-constexpr float TEXT_LAYOUT1_X = 0.6f;
-constexpr float TEXT_LAYOUT1_Y = 3.f / 8.f;
-constexpr float TEXT_LAYOUT2_X = 0.35f;
-constexpr float TEXT_LAYOUT2_Y = 0.3f;
-
 constexpr glm::vec4 BUTTON_LINE_COLOR = Color::white;
 constexpr glm::vec4 BUTTON_FILL_COLOR = Color::blue;
 float BUTTON_LINE_THICKNESS = 0.005f;
-constexpr float BUTTON_RADIUS = 0.06f;
-constexpr float BUTTON_PADDING = 0.02f;
 
 constexpr glm::vec4 FONT_FG = Color::yellow;
 constexpr glm::vec4 FONT_FG2 = Color::yellow;
@@ -59,14 +53,21 @@ constexpr float FONT_ENLARGE_SCALE = 1.3f;
 constexpr float FONT_SPACING = 0.1f;
 const glm::vec2 FONT_OFFSET = {-0.02f, 0.05f};
 
-constexpr float BOUNCE_ANIM_INITIAL_VEL = -0.25f;
-constexpr float BOUNCE_ANIM_ACC = 1.f;
-constexpr float BOUNCE_ANIM_DECAY = 0.75f;
-constexpr float BOUNCE_ANIM_DURATION_SEC = 2.5f;
+constexpr float GAME_STEP_SEC = 1.f / 120.f;
+constexpr float GAME_MAX_BACKLOG_SEC = 0.25f;  // steps dropped after a stall instead of replayed
 
-constexpr float GAME_DELAY_DURATION_SEC = 1.f;
+constexpr float PROFILE_FONT_WIDTH = 0.03f;
+const glm::vec2 PROFILE_OVERLAY_POS = {0.01f, 0.04f};
+constexpr uint32_t PROFILE_OVERLAY_REFRESH_FRAMES = 30;
 
-enum class AudioEnum { BGM, CLICK, CLAP, WIN };
+enum class AudioEnum { CLICK, CLAP, WIN };
+
+#ifdef __EMSCRIPTEN__
+// no pthreads in the wasm build, decode on the main thread when polled
+constexpr auto AUDIO_DECODE_POLICY = std::launch::deferred;
+#else
+constexpr auto AUDIO_DECODE_POLICY = std::launch::async;
+#endif
 
 struct AppState {
     SDL_Window *window = nullptr;
@@ -75,15 +76,19 @@ struct AppState {
     SDL_AudioDeviceID audio_device = 0;
 
     std::map<AudioEnum, Audio> audio;
+    std::map<AudioEnum, std::future<std::optional<Audio>>> audio_pending;  // moved into audio when decoded
+    MixerPtr mixer{{}, {}};
+    MusicPtr bgm{{}, {}};
 
     bool init = false;
     bool mouse_down = false;
-    int done_count = 0;
 
-    std::array<int, SEQ_LEN> number_sequence;
-    std::array<bool, SEQ_LEN> number_done;
+    Game game{std::random_device{}()};
+    GameInput input;  // consumed by the next game step
+    uint64_t last_step_tick = 0;
+    float step_acc = 0;  // seconds not yet stepped
 
-    VertexArrayPtr vao{{}, {}};
+    UniformBufferPtr frame_uniform{{}, {}};
 
     FontAtlas font;
     FontShader font_shader;
@@ -92,36 +97,20 @@ struct AppState {
     Shape draw_area_bg;
     Shape button;
 
-    float text_x;
-    float text_y;
-
-    std::array<VertexBufferPtr, 10> number{
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-        VertexBufferPtr{{}, {}},
-    };
+    // refilled every frame
+    ShapeBatch button_batch;
+    TextBatch text_batch;
 
+    std::array<std::vector<GlyphQuad>, 10> number;
     std::array<BBox, 10> number_bbox;
-    std::array<glm::vec2, 10> button_center;
 
-    // time dependent events
-    uint64_t bounce_anim_start = 0;
-    uint64_t bounce_anim_end = 0;
-    float bounce_vel = -1.f;
+    FrameBench bench;
 
-    uint64_t game_delay_end = 0;
+    GpuTimerPtr gpu_timer{{}, {}};  // null without GL_EXT_disjoint_timer_query
+    bool show_profile = false;
+    std::vector<GlyphQuad> profile_text;  // refreshed every PROFILE_OVERLAY_REFRESH_FRAMES
 };
 
-void init_button_layout1(AppState &as);
-void init_button_layout2(AppState &as);
-
 bool resize_event(AppState &as) {
     int win_w, win_h;
 
@@ -154,38 +143,19 @@ bool resize_event(AppState &as) {
     glViewport(0, 0, win_w, win_h);
     glm::mat4 ortho = glm::ortho(norm_x(0.f), norm_x(win_wf), norm_y(win_hf), norm_y(0.f));
 
-    as.shape_shader.set_ortho(ortho);
+    FrameUniform frame{};
+    frame.ortho_matrix = ortho;
+    frame.display_width = draw_area_size.x;
+    as.frame_uniform->update(&frame);
+    as.frame_uniform->bind();
+
     as.shape_shader.draw_area_size = draw_area_size;
     as.shape_shader.draw_area_offset = draw_area_offset;
 
-    as.font_shader.set_ortho(ortho);
-    as.font_shader.set_display_width(draw_area_size.x);
-
     return true;
 }
 
-void init_game(AppState &as) {
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::uniform_int_distribution<> dice(0, 9);
-
-    std::generate(as.number_sequence.begin(), as.number_sequence.end(), [&] { return dice(g); });
-    std::fill(as.number_done.begin(), as.number_done.end(), false);
-
-    if (as.done_count % 2 == 0) {
-        init_button_layout1(as);
-    } else {
-        init_button_layout2(as);
-    }
-
-    resize_event(as);
-}
-
 void mouse_down_event(AppState &as) {
-    if (as.game_delay_end > 0) {
-        return;
-    }
-
     if (as.mouse_down) {
         return;
     }
@@ -195,40 +165,34 @@ void mouse_down_event(AppState &as) {
     float cx = 0, cy = 0;
     SDL_GetMouseState(&cx, &cy);
 
-    glm::vec2 pos = screen_pos_to_normalize_pos(as.shape_shader, {cx, cy});
-    glm::vec2 radius{BUTTON_RADIUS, BUTTON_RADIUS};
-
-    for (size_t i = 0; i < as.button_center.size(); i++) {
-        const glm::vec2 &c = as.button_center[i];
-        glm::vec2 start = c - radius;
-        glm::vec2 end = c + radius;
+    as.input.press = true;
+    as.input.pos = screen_pos_to_normalize_pos(as.shape_shader, {cx, cy});
+}
 
-        if ((pos.x > start.x) && (pos.x < end.x) && (pos.y > start.y) && (pos.y < end.y)) {
-            as.audio[AudioEnum::CLICK].play(true);
-            int num_click = static_cast<int>(i + 1) % 10;
+// Run the game rules in fixed steps to catch up with real time, play sounds for what happened
+void step_game(AppState &as) {
+    uint64_t now = SDL_GetTicksNS();
+    if (as.last_step_tick == 0) {
+        as.last_step_tick = now;
+    }
 
-            for (size_t j = 0; j < as.number_done.size(); j++) {
-                if (!as.number_done[j]) {
-                    if (num_click == as.number_sequence[j]) {
-                        as.number_done[j] = true;
-                        as.bounce_anim_start = 0;
-                    }
+    float elapsed = static_cast<float>(static_cast<double>(now - as.last_step_tick) * 1e-9);
+    as.step_acc = std::min(as.step_acc + elapsed, GAME_MAX_BACKLOG_SEC);
+    as.last_step_tick = now;
 
-                    break;
-                }
-            }
+    while (as.step_acc >= GAME_STEP_SEC) {
+        GameEvents events = as.game.update(as.input, GAME_STEP_SEC);
+        as.input = {};
+        as.step_acc -= GAME_STEP_SEC;
 
-            break;
+        if (events.click) {
+            as.mixer->play(as.audio[AudioEnum::CLICK]);
         }
-    }
 
-    // check if we wont
-    auto is_true = [](bool b) { return b; };
-    if (std::all_of(as.number_done.begin(), as.number_done.end(), is_true)) {
-        as.audio[AudioEnum::WIN].play(true);
-        as.audio[AudioEnum::CLAP].play(true);
-        as.game_delay_end = SDL_GetTicksNS() + SDL_SECONDS_TO_NS(GAME_DELAY_DURATION_SEC);
-        as.done_count++;
+        if (events.win) {
+            as.mixer->play(as.audio[AudioEnum::WIN]);
+            as.mixer->play(as.audio[AudioEnum::CLAP]);
+        }
     }
 }
 
@@ -239,104 +203,93 @@ bool init_audio(AppState &as, const std::string &base_path) {
         return false;
     }
 
-    if (auto w = load_ogg(as.audio_device, (base_path + "bgm.ogg").c_str(), 0.2f)) {
-        as.audio[AudioEnum::BGM] = *w;
-    } else {
-        return false;
-    }
-
-    if (auto w = load_ogg(as.audio_device, (base_path + "win.ogg").c_str())) {
-        as.audio[AudioEnum::WIN] = *w;
-    } else {
+    as.mixer = make_mixer(as.audio_device);
+    if (!as.mixer) {
         return false;
     }
 
-    if (auto w = load_ogg(as.audio_device, (base_path + "clap.ogg").c_str())) {
-        as.audio[AudioEnum::CLAP] = *w;
-    } else {
+    as.bgm = load_music(as.audio_device, (base_path + "bgm.ogg").c_str(), 0.2f);
+    if (!as.bgm) {
         return false;
     }
 
-    if (auto w = load_ogg(as.audio_device, (base_path + "switch30.ogg").c_str())) {
-        as.audio[AudioEnum::CLICK] = *w;
-    } else {
-        return false;
-    }
+    as.bgm->play();
 
-    return true;
-}
+    // Sound effects are decoded in the background, until then playing them is a no-op
+    const std::map<AudioEnum, std::string> effect = {
+        {AudioEnum::WIN, "win.ogg"},
+        {AudioEnum::CLAP, "clap.ogg"},
+        {AudioEnum::CLICK, "switch30.ogg"},
+    };
 
-bool init_font(AppState &as, const std::string &base_path) {
-    if (!as.font.load(base_path + "atlas.bmp", base_path + "atlas.txt")) {
-        return false;
-    }
+    // decode straight to float when the device mixes in float, saves a conversion per sample,
+    // and at the mixer rate so no voice has to resample
+    const SDL_AudioFormat format = decode_format(as.audio_device);
+    const int freq = as.mixer->spec.freq;
 
-    if (!as.font_shader.init(as.font)) {
-        return false;
+    for (const auto &[id, file] : effect) {
+        std::string path = base_path + file;
+        auto decode = [path, format, freq] { return load_ogg(path.c_str(), 1.0f, format, freq); };
+        as.audio_pending[id] = std::async(AUDIO_DECODE_POLICY, decode);
     }
 
     return true;
 }
 
-void init_button_layout1(AppState &as) {
-    constexpr int cols = 3;
-    constexpr int rows = 4;
+// Pick up the sound effects that finished decoding
+void poll_audio(AppState &as) {
+    const bool had_pending = !as.audio_pending.empty();
 
-    float total_w = (BUTTON_RADIUS * 2) * cols + BUTTON_PADDING * (cols - 1);
-    float total_h = (BUTTON_RADIUS * 2) * rows + BUTTON_PADDING * (rows - 1);
+    for (auto it = as.audio_pending.begin(); it != as.audio_pending.end();) {
+        auto status = it->second.wait_for(std::chrono::seconds(0));
+
+        if (status == std::future_status::timeout) {
+            it++;
+            continue;
+        }
 
-    float xoff = BUTTON_RADIUS + (NORM_WIDTH * 0.5f - total_w) * 0.5f;
-    float yoff = BUTTON_RADIUS + (NORM_HEIGHT - total_h) * 0.5f;
+        if (auto a = it->second.get()) {
+            as.audio[it->first] = std::move(*a);
+        } else {
+            LOG("Failed to load sound effect %d", static_cast<int>(it->first));
+        }
 
-    size_t idx = 0;
-    for (size_t i = 0; i < 3; i++) {
-        for (size_t j = 0; j < 3; j++) {
-            float x = xoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(j);
-            float y = yoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(i);
+        it = as.audio_pending.erase(it);
 
-            as.button_center[idx] = {x, y};
-            idx++;
+        // deferred decodes run right here, spread them over frames
+        if (status == std::future_status::deferred) {
+            break;
         }
     }
 
-    // zero
-    float x = xoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(1);
-    float y = yoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(3);
-    as.button_center[9] = {x, y};
-
-    as.text_x = TEXT_LAYOUT1_X;
-    as.text_y = TEXT_LAYOUT1_Y;
+    // every cache key this session needs is known now
+    if (had_pending && as.audio_pending.empty()) {
+        audio_cache_prune();
+    }
 }
 
-void init_button_layout2(AppState &as) {
-    constexpr int cols = 5;
-    constexpr int rows = 2;
-
-    float total_w = (BUTTON_RADIUS * 2) * cols + BUTTON_PADDING * (cols - 1);
-    float total_h = (BUTTON_RADIUS * 2) * rows + BUTTON_PADDING * (rows - 1);
-
-    float xoff = BUTTON_RADIUS + (NORM_WIDTH - total_w) * 0.5f;
-    float yoff = BUTTON_RADIUS + NORM_HEIGHT * 0.5f + (NORM_HEIGHT * 0.5f - total_h) * 0.5f;
-
-    size_t idx = 0;
-    for (size_t i = 0; i < rows; i++) {
-        for (size_t j = 0; j < cols; j++) {
-            float x = xoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(j);
-            float y = yoff + (2 * BUTTON_RADIUS + BUTTON_PADDING) * static_cast<float>(i);
-
-            as.button_center[idx] = {x, y};
-            idx++;
+bool init_font(AppState &as, const std::string &base_path) {
+    // Prefer the precompiled atlas, fall back to the msdf-atlas-gen output
+    if (!as.font.load_binary(base_path + "atlas.bin")) {
+        if (!as.font.load(base_path + "atlas.bmp", base_path + "atlas.txt")) {
+            return false;
         }
     }
 
-    as.text_x = TEXT_LAYOUT2_X;
-    as.text_y = TEXT_LAYOUT2_Y;
+    if (!as.font_shader.init(as.font)) {
+        return false;
+    }
+
+    return true;
 }
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
-    // Unused
-    (void)argc;
-    (void)argv;
+    // Headless benchmark, runs without a display or a sound card
+    const int bench_frames = parse_bench_frames(argc, argv);
+    if (bench_frames > 0) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+    }
 
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         LOG("SDL_Init failed: %s", SDL_GetError());
@@ -351,6 +304,7 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     }
 
     *appstate = as;
+    as->bench.frames = bench_frames;
 
     std::string base_path = "assets/";
 #ifdef __ANDROID__
@@ -369,13 +323,18 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     // Android
     SDL_SetHint(SDL_HINT_ORIENTATIONS, "LandscapeLeft LandscapeRight");
 
-    if (!SDL_CreateWindowAndRenderer(
-            "Number Sequence Game", 640, 480, SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL, &as->window, &as->renderer)) {
+    SDL_WindowFlags window_flags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL;
+    if (as->bench.enabled()) {
+        window_flags |= SDL_WINDOW_HIDDEN;
+    }
+
+    if (!SDL_CreateWindowAndRenderer("Number Sequence Game", 640, 480, window_flags, &as->window, &as->renderer)) {
         LOG("SDL_CreateWindowAndRenderer failed");
         return SDL_APP_FAILURE;
     }
 
-    if (!SDL_SetRenderVSync(as->renderer, 1)) {
+    // the benchmark wants raw frame cost, not the display rate
+    if (!SDL_SetRenderVSync(as->renderer, as->bench.enabled() ? 0 : 1)) {
         LOG("SDL_SetRenderVSync failed");
         return SDL_APP_FAILURE;
     }
@@ -386,22 +345,32 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     enable_gl_debug_callback();
 #endif
 
+    as->gpu_timer = make_gpu_timer();
+
+    if (as->bench.enabled()) {
+        SDL_GL_SetSwapInterval(0);
+
+        int w, h;
+        if (!SDL_GetWindowSize(as->window, &w, &h) || !as->bench.init(w, h, as->gpu_timer.get())) {
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    as->frame_uniform = make_uniform_buffer(FRAME_UNIFORM_BINDING, sizeof(FrameUniform));
+
     if (!init_font(*as, base_path)) {
         return SDL_APP_FAILURE;
     }
 
     for (size_t i = 0; i < as->number.size(); i++) {
-        auto [vertex_buffer, bbox] = as->font.make_text(std::to_string(i).c_str(), true);
-        as->number[i] = std::move(vertex_buffer);
-        as->number_bbox[i] = bbox;
+        as->number[i] = as->font.make_glyph_quad(std::to_string(i), true);
+        as->number_bbox[i] = bbox(as->number[i]);
     }
 
     if (!as->shape_shader.init()) {
         return SDL_APP_FAILURE;
     }
 
-    as->vao = make_vertex_array();
-
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -430,14 +399,12 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
         as->button = make_shape(vertex, BUTTON_LINE_THICKNESS, BUTTON_LINE_COLOR, BUTTON_FILL_COLOR);
     }
 
-    init_button_layout2(*as);
-    init_game(*as);
-
     return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     AppState &as = *static_cast<AppState *>(appstate);
+    ScopedTimer zone(Zone::EVENT);
 
     switch (event->type) {
         case SDL_EVENT_QUIT:
@@ -458,6 +425,10 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
                 }
             }
 
+            if (event->key.key == SDLK_P) {
+                as.show_profile = !as.show_profile;
+            }
+
             break;
 
         case SDL_EVENT_WINDOW_RESIZED:
@@ -482,138 +453,178 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result) {
 
     if (appstate) {
         AppState &as = *static_cast<AppState *>(appstate);
+
+        LOG("GL state calls issued: %llu, skipped: %llu",
+            static_cast<unsigned long long>(gl_state().issued),
+            static_cast<unsigned long long>(gl_state().skipped));
+
+        profiler().log_summary();
+
+        // last thousand or so frames, for jank reports from the field
+        if (char *pref = SDL_GetPrefPath("nghiaho12", "number_sequence_game")) {
+            profiler().dump((std::string(pref) + "profile.csv").c_str());
+            SDL_free(pref);
+        }
+
         SDL_DestroyRenderer(as.renderer);
         SDL_DestroyWindow(as.window);
 
         SDL_CloseAudioDevice(as.audio_device);
 
         // TODO: This code causes a crash as of libSDL preview-3.1.6
-        // for (auto &a: as.audio) {
-        //     if (a.second.stream) {
-        //         SDL_DestroyAudioStream(a.second.stream);
-        //     }
-        // }
+        // SDL_DestroyAudioStream(as.mixer->stream);
+        // SDL_DestroyAudioStream(as.bgm->stream);
 
         delete &as;
     }
 }
 
-SDL_AppResult SDL_AppIterate(void *appstate) {
-    AppState &as = *static_cast<AppState *>(appstate);
-
-    if (as.game_delay_end != 0 && SDL_GetTicksNS() > as.game_delay_end) {
-        as.game_delay_end = 0;
-        init_game(as);
-    }
-
-    auto &bgm = as.audio[AudioEnum::BGM];
-    if (SDL_GetAudioStreamAvailable(bgm.stream) < static_cast<int>(bgm.data.size())) {
-        bgm.play(false);
-    }
-
-#ifndef __EMSCRIPTEN__
-    SDL_GL_MakeCurrent(as.window, as.gl_ctx);
-#endif
-
-    as.shape_shader.shader->use();
-
-    if (!as.init) {
-        resize_event(as);
-        as.init = true;
-    }
-
-    glDisable(GL_DEPTH_TEST);
-    glClearColor(0.0, 0.0, 0.0, 1.0);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    as.vao->use();
-
-    float cx = 0, cy = 0;
-    SDL_GetMouseState(&cx, &cy);
-
-    draw_shape(as.shape_shader, as.draw_area_bg, true, false, false);
+// Refill the button and text batches for this frame, the next digit to find bounces
+void update_batches(AppState &as) {
+    as.button_batch.clear();
+    as.text_batch.clear();
 
-    as.font_shader.set_fg(FONT_FG);
-    as.font_shader.set_bg(FONT_BG);
-    as.font_shader.set_outline(FONT_OUTLINE);
-    as.font_shader.set_outline_factor(FONT_OUTLINE_FACTOR);
-    as.font_shader.set_font_width(FONT_WIDTH);
+    TextStyle button_style{FONT_WIDTH, FONT_FG, FONT_BG, FONT_OUTLINE, FONT_OUTLINE_FACTOR};
 
     size_t i = 0;
-    for (const auto &center : as.button_center) {
-        as.button.trans = center;
-        draw_shape(as.shape_shader, as.button, true, true, false);
+    for (const auto &center : as.game.button_center) {
+        as.button_batch.add(center);
 
         glm::vec2 bbox_center = (as.number_bbox[i].start + as.number_bbox[i].end) * 0.5f;
         bbox_center -= FONT_OFFSET;
         bbox_center *= FONT_WIDTH;
 
-        as.font_shader.set_trans(center - bbox_center);
-        draw_vertex_buffer(as.font_shader.shader, as.number[(i + 1) % 10], as.font.tex);
+        as.text_batch.add(as.number[(i + 1) % 10], center - bbox_center, button_style);
 
         i++;
     }
 
-    as.font_shader.set_bg(FONT_BG);
-    as.font_shader.set_outline_factor(0.1f);
-
     bool do_anim = true;
 
-    for (size_t i = 0; i < as.number_sequence.size(); i++) {
-        glm::vec2 pos{as.text_x + static_cast<float>(i) * FONT_SPACING, as.text_y * NORM_HEIGHT};
+    for (size_t i = 0; i < as.game.number_sequence.size(); i++) {
+        glm::vec2 pos{as.game.text_x + static_cast<float>(i) * FONT_SPACING, as.game.text_y * NORM_HEIGHT};
 
-        int num = as.number_sequence[i];
+        int num = as.game.number_sequence[i];
 
         glm::vec2 bbox_center = (as.number_bbox[i].start + as.number_bbox[i].end) * 0.5f;
         bbox_center -= FONT_OFFSET;
 
-        if (as.number_done[i]) {
+        TextStyle style{FONT_WIDTH, FONT_FG2, FONT_BG, FONT_OUTLINE, 0.1f};
+
+        if (as.game.number_done[i]) {
             bbox_center *= FONT_WIDTH * FONT_ENLARGE_SCALE;
 
-            as.font_shader.set_font_width(FONT_WIDTH * FONT_ENLARGE_SCALE);
-            as.font_shader.set_fg(FONT_FG2);
-            as.font_shader.set_outline(FONT_OUTLINE);
+            style.font_width = FONT_WIDTH * FONT_ENLARGE_SCALE;
         } else {
             bbox_center *= FONT_WIDTH;
 
-            as.font_shader.set_font_width(FONT_WIDTH);
-            as.font_shader.set_fg(Color::transparent);
-            as.font_shader.set_outline(FONT_OUTLINE2);
+            style.fg = Color::transparent;
+            style.outline = FONT_OUTLINE2;
 
             if (do_anim) {
-                if (as.bounce_anim_start == 0) {
-                    as.bounce_anim_start = SDL_GetTicksNS();
-                    as.bounce_anim_end = as.bounce_anim_start + SDL_SECONDS_TO_NS(BOUNCE_ANIM_DURATION_SEC);
-                    as.bounce_vel = BOUNCE_ANIM_INITIAL_VEL;
-                }
+                pos.y += as.game.bounce_offset;
+                do_anim = false;
+            }
+        }
 
-                float u = as.bounce_vel;
-                float a = BOUNCE_ANIM_ACC;
-                float t = static_cast<float>(static_cast<double>(SDL_GetTicksNS() - as.bounce_anim_start) * 1e-9);
-                float d = u * t + a * t * t * 0.5f;
+        as.text_batch.add(as.number[static_cast<size_t>(num)], pos - bbox_center, style);
+    }
+}
 
-                if (d > 0) {
-                    d = 0;
-                    as.bounce_vel *= BOUNCE_ANIM_DECAY;
-                    as.bounce_anim_start = SDL_GetTicksNS();
+// Frame time percentiles in the top-left corner, toggled with P
+void update_profile_overlay(AppState &as) {
+    if (!as.show_profile) {
+        return;
+    }
 
-                    if (SDL_GetTicksNS() > as.bounce_anim_end) {
-                        as.bounce_vel = BOUNCE_ANIM_INITIAL_VEL;
-                        as.bounce_anim_end = as.bounce_anim_start + SDL_SECONDS_TO_NS(BOUNCE_ANIM_DURATION_SEC);
-                    }
-                }
+    // percentiles sort the whole ring, refresh a few times a second
+    const Profiler &p = profiler();
+    if (as.profile_text.empty() || p.frame % PROFILE_OVERLAY_REFRESH_FRAMES == 0) {
+        char text[64];
+        snprintf(text,
+                 sizeof(text),
+                 "frame p50 %.1f p99 %.1f ms",
+                 p.percentile_ms(Zone::FRAME, 0.5),
+                 p.percentile_ms(Zone::FRAME, 0.99));
+        as.profile_text = as.font.make_glyph_quad(text, true);
+    }
 
-                pos.y += d;
+    TextStyle style{PROFILE_FONT_WIDTH, FONT_FG, FONT_BG, FONT_OUTLINE, FONT_OUTLINE_FACTOR};
+    as.text_batch.add(as.profile_text, PROFILE_OVERLAY_POS, style);
+}
 
-                do_anim = false;
-            }
+SDL_AppResult SDL_AppIterate(void *appstate) {
+    AppState &as = *static_cast<AppState *>(appstate);
+
+    profiler().next_frame();
+    ScopedTimer frame_zone(Zone::FRAME);
+
+#ifndef __EMSCRIPTEN__
+    SDL_GL_MakeCurrent(as.window, as.gl_ctx);
+#endif
+
+    if (as.bench.enabled()) {
+        as.bench.begin_frame();
+    }
+
+    if (as.gpu_timer) {
+        as.gpu_timer->collect();
+    }
+
+    {
+        ScopedTimer zone(Zone::UPDATE);
+
+        step_game(as);
+        poll_audio(as);
+        update_batches(as);
+        update_profile_overlay(as);
+    }
+
+    as.shape_shader.shader->use();
+
+    if (!as.init) {
+        resize_event(as);
+        as.init = true;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    {
+        ScopedTimer zone(Zone::SHAPE);
+        ScopedGpuTimer gpu_zone(as.gpu_timer, Zone::GPU_BACKGROUND);
+        draw_shape(as.shape_shader, as.draw_area_bg, true, false, false);
+    }
+
+    {
+        ScopedTimer zone(Zone::SHAPE);
+        ScopedGpuTimer gpu_zone(as.gpu_timer, Zone::GPU_BUTTON);
+        draw_shape_batch(as.shape_shader, as.button, as.button_batch, true, true, false);
+    }
+
+    // button and sequence digits, all glyphs go through the MSDF fragment shader
+    {
+        ScopedTimer zone(Zone::TEXT);
+        ScopedGpuTimer gpu_zone(as.gpu_timer, Zone::GPU_DIGIT);
+        draw_text_batch(as.font_shader, as.font, as.text_batch);
+    }
+
+    if (as.bench.enabled()) {
+        as.bench.end_frame();
+
+        if (as.bench.done()) {
+            as.bench.report();
+            return SDL_APP_SUCCESS;
         }
 
-        as.font_shader.set_trans(pos - bbox_center);
-        draw_vertex_buffer(as.font_shader.shader, as.number[static_cast<size_t>(num)], as.font.tex);
+        return SDL_APP_CONTINUE;
     }
 
-    SDL_GL_SwapWindow(as.window);
+    {
+        ScopedTimer zone(Zone::SWAP);
+        SDL_GL_SwapWindow(as.window);
+    }
 
     return SDL_APP_CONTINUE;
 }
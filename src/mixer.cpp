@@ -0,0 +1,183 @@
+#include "mixer.hpp"
+
+#include <algorithm>
+
+#include "audio_kernel.hpp"
+#include "log.hpp"
+
+namespace {
+constexpr int MIXER_CHANNELS = 2;
+constexpr uint64_t FIXED_ONE = uint64_t(1) << 32;
+
+void SDLCALL mixer_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
+    (void)total_amount;
+
+    Mixer &m = *static_cast<Mixer *>(userdata);
+    int frames = additional_amount / static_cast<int>(sizeof(float) * MIXER_CHANNELS);
+
+    while (frames > 0) {
+        int n = std::min(frames, Mixer::BLOCK_FRAMES);
+        m.mix(m.block.data(), n);
+        SDL_PutAudioStreamData(stream, m.block.data(), n * static_cast<int>(sizeof(float)) * MIXER_CHANNELS);
+        frames -= n;
+    }
+}
+
+void mix_run(float *out, const int16_t *src, size_t n, int channels, float gain) {
+    if (channels == 2) {
+        mix_s16(out, src, n * 2, gain);
+    } else {
+        mix_s16_mono_to_stereo(out, src, n, gain);
+    }
+}
+
+void mix_run(float *out, const float *src, size_t n, int channels, float gain) {
+    if (channels == 2) {
+        mix_f32(out, src, n * 2, gain);
+    } else {
+        mix_f32_mono_to_stereo(out, src, n, gain);
+    }
+}
+
+constexpr float sample_scale(int16_t) { return 1.0f / 32768.0f; }
+constexpr float sample_scale(float) { return 1.0f; }
+
+// Accumulate one voice into out, returns false when the voice ran off the end
+template <typename T>
+bool mix_voice(Voice &v, const T *src, float *out, int frames, float master_gain) {
+    const int channels = v.audio.spec.channels;
+    const uint64_t src_frames = v.audio.frames();
+    const float gain = v.gain * master_gain;
+
+    // same rate, straight run through the kernels
+    if (v.step == FIXED_ONE && channels <= 2) {
+        uint64_t f = v.pos >> 32;
+        size_t n = static_cast<size_t>(std::min(static_cast<uint64_t>(frames), src_frames - std::min(f, src_frames)));
+
+        mix_run(out, src + f * static_cast<size_t>(channels), n, channels, gain);
+
+        v.pos += static_cast<uint64_t>(n) << 32;
+        return (v.pos >> 32) < src_frames;
+    }
+
+    // clips not resampled at load step through at the nearest frame,
+    // stereo sources use the first two channels, mono goes to both
+    const size_t right = channels > 1 ? 1 : 0;
+    const float scale = gain * sample_scale(T{});
+
+    for (int i = 0; i < frames; i++) {
+        uint64_t f = v.pos >> 32;
+        if (f >= src_frames) {
+            return false;
+        }
+
+        const T *s = src + f * static_cast<size_t>(channels);
+        out[i * 2] += static_cast<float>(s[0]) * scale;
+        out[i * 2 + 1] += static_cast<float>(s[right]) * scale;
+
+        v.pos += v.step;
+    }
+
+    return (v.pos >> 32) < src_frames;
+}
+
+bool mix_voice(Voice &v, float *out, int frames, float master_gain) {
+    if (v.audio.pcm_f32) {
+        return mix_voice(v, v.audio.pcm_f32->data(), out, frames, master_gain);
+    }
+    return mix_voice(v, v.audio.pcm->data(), out, frames, master_gain);
+}
+
+bool active(const Voice &v) { return v.audio.pcm || v.audio.pcm_f32; }
+
+uint64_t frames_left(const Voice &v) {
+    uint64_t src_frames = v.audio.frames();
+    return src_frames - std::min(src_frames, v.pos >> 32);
+}
+
+}  // namespace
+
+void Mixer::play(const Audio &audio, float gain) {
+    if (!stream || audio.frames() == 0) {
+        return;
+    }
+
+    SDL_LockAudioStream(stream);
+
+    auto slot = std::find_if(voice.begin(), voice.end(), [](const Voice &v) { return !active(v); });
+
+    if (slot == voice.end()) {
+        slot = std::min_element(
+            voice.begin(), voice.end(), [](const Voice &a, const Voice &b) { return frames_left(a) < frames_left(b); });
+    }
+
+    slot->audio = audio;
+    slot->pos = 0;
+    slot->step = static_cast<uint64_t>(audio.spec.freq) * FIXED_ONE / static_cast<uint64_t>(spec.freq);
+    slot->gain = audio.gain * gain;
+
+    SDL_UnlockAudioStream(stream);
+}
+
+void Mixer::mix(float *out, int frames) {
+    std::fill(out, out + frames * MIXER_CHANNELS, 0.0f);
+
+    for (auto &v : voice) {
+        if (active(v) && !mix_voice(v, out, frames, master_gain)) {
+            v.audio = Audio{};
+        }
+    }
+
+    saturate_f32(out, static_cast<size_t>(frames * MIXER_CHANNELS));
+}
+
+void Mixer::set_master_gain(float gain) {
+    if (stream) {
+        SDL_LockAudioStream(stream);
+        master_gain = gain;
+        SDL_UnlockAudioStream(stream);
+    }
+}
+
+MixerPtr make_mixer(SDL_AudioDeviceID audio_device) {
+    auto cleanup = [](Mixer *m) {
+        if (m->stream) {
+            SDL_SetAudioStreamGetCallback(m->stream, nullptr, nullptr);
+        }
+        delete m;
+    };
+
+    MixerPtr m(new Mixer, cleanup);
+
+    SDL_AudioSpec device_spec{};
+    if (!SDL_GetAudioDeviceFormat(audio_device, &device_spec, nullptr)) {
+        LOG("Couldn't query audio device format: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    m->spec.format = SDL_AUDIO_F32;
+    m->spec.channels = MIXER_CHANNELS;
+    m->spec.freq = device_spec.freq;
+    m->block.resize(static_cast<size_t>(Mixer::BLOCK_FRAMES * MIXER_CHANNELS));
+
+    m->stream = SDL_CreateAudioStream(&m->spec, NULL);
+
+    if (!m->stream) {
+        LOG("Couldn't create audio stream: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    if (!SDL_SetAudioStreamGetCallback(m->stream, mixer_callback, m.get())) {
+        LOG("Couldn't set mixer callback: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    if (!SDL_BindAudioStream(audio_device, m->stream)) {
+        LOG("Failed to bind stream to device: %s", SDL_GetError());
+        return {{}, {}};
+    }
+
+    SDL_ResumeAudioStreamDevice(m->stream);
+
+    return m;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL3/SDL_audio.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "audio.hpp"
+
+// One sound effect playing, references the shared PCM so nothing is copied per play
+struct Voice {
+    Audio audio;  // no PCM when the voice is free
+    uint64_t pos = 0;   // frame position, 32.32 fixed point
+    uint64_t step = 0;  // source frames per output frame, 32.32 fixed point
+    float gain = 1.0f;
+};
+
+// Mixes all sound effects into a single stream from the SDL audio thread.
+// Output is F32 stereo at the device rate.
+struct Mixer {
+    static constexpr int MAX_VOICES = 16;
+    static constexpr int BLOCK_FRAMES = 512;
+
+    SDL_AudioStream *stream = nullptr;
+    SDL_AudioSpec spec{};
+    std::array<Voice, MAX_VOICES> voice;
+    float master_gain = 1.0f;
+    std::vector<float> block;  // audio thread only
+
+    // Starts a new voice, overlapping whatever is already playing.
+    // Steals the voice closest to finishing when the pool is full.
+    void play(const Audio &audio, float gain = 1.0f);
+    void set_master_gain(float gain);
+
+    void mix(float *out, int frames);  // called with the stream locked
+};
+
+using MixerPtr = std::unique_ptr<Mixer, void (*)(Mixer *)>;
+
+MixerPtr make_mixer(SDL_AudioDeviceID audio_device);
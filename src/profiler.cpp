@@ -0,0 +1,137 @@
+#include "profiler.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "log.hpp"
+
+const char *zone_name(Zone zone) {
+    switch (zone) {
+        case Zone::FRAME:
+            return "frame";
+        case Zone::EVENT:
+            return "event";
+        case Zone::UPDATE:
+            return "update";
+        case Zone::SHAPE:
+            return "shape";
+        case Zone::TEXT:
+            return "text";
+        case Zone::SWAP:
+            return "swap";
+        case Zone::GPU_BACKGROUND:
+            return "gpu_background";
+        case Zone::GPU_BUTTON:
+            return "gpu_button";
+        case Zone::GPU_DIGIT:
+            return "gpu_digit";
+        case Zone::COUNT:
+            break;
+    }
+
+    return "?";
+}
+
+void Profiler::record(Zone zone, uint64_t start, uint64_t end, uint32_t sample_frame) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    ring[h & (CAPACITY - 1)] = {start, end, sample_frame, zone};
+    head.store(h + 1, std::memory_order_release);
+}
+
+std::vector<ProfileSample> Profiler::snapshot() const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+    std::vector<ProfileSample> ret;
+    ret.reserve(static_cast<size_t>(end - begin));
+
+    for (uint64_t i = begin; i < end; i++) {
+        ret.push_back(ring[i & (CAPACITY - 1)]);
+    }
+
+    // anything the writer got to while copying is from a newer lap
+    uint64_t now = head.load(std::memory_order_acquire);
+    uint64_t valid = now > CAPACITY ? now - CAPACITY : 0;
+
+    if (valid > begin) {
+        ret.erase(ret.begin(), ret.begin() + static_cast<std::ptrdiff_t>(std::min(valid - begin, end - begin)));
+    }
+
+    return ret;
+}
+
+double Profiler::percentile_ms(Zone zone, double q) const {
+    std::vector<uint64_t> total;
+    uint32_t last_frame = 0;
+
+    // samples of one zone are in frame order, sum each frame's samples
+    for (const auto &s : snapshot()) {
+        if (s.zone != zone) {
+            continue;
+        }
+
+        if (total.empty() || s.frame != last_frame) {
+            total.push_back(0);
+            last_frame = s.frame;
+        }
+
+        total.back() += s.end - s.start;
+    }
+
+    if (total.empty()) {
+        return 0;
+    }
+
+    size_t i = static_cast<size_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total.size() - 1));
+    std::nth_element(total.begin(), total.begin() + static_cast<std::ptrdiff_t>(i), total.end());
+
+    return static_cast<double>(total[i]) * 1e-6;
+}
+
+bool Profiler::dump(const char *path) const {
+    std::string csv = "frame,zone,start_ns,duration_ns\n";
+    char line[96];
+
+    for (const auto &s : snapshot()) {
+        snprintf(line,
+                 sizeof(line),
+                 "%u,%s,%llu,%llu\n",
+                 s.frame,
+                 zone_name(s.zone),
+                 static_cast<unsigned long long>(s.start),
+                 static_cast<unsigned long long>(s.end - s.start));
+        csv += line;
+    }
+
+    if (!SDL_SaveFile(path, csv.data(), csv.size())) {
+        LOG("Failed to write profile '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    LOG("Profile written to '%s'", path);
+
+    return true;
+}
+
+void Profiler::log_summary() const {
+    for (int z = 0; z < static_cast<int>(Zone::COUNT); z++) {
+        Zone zone = static_cast<Zone>(z);
+        double p99 = percentile_ms(zone, 0.99);
+
+        if (p99 > 0) {
+            LOG("profile %s: p50 %.3f ms, p99 %.3f ms", zone_name(zone), percentile_ms(zone, 0.5), p99);
+        }
+    }
+}
+
+Profiler &profiler() {
+    static Profiler p;
+    return p;
+}
+
+ScopedTimer::ScopedTimer(Zone z) : zone(z), start(SDL_GetTicksNS()) {}
+
+ScopedTimer::~ScopedTimer() { profiler().record(zone, start, SDL_GetTicksNS()); }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-frame zones, a zone can be recorded more than once per frame.
+// GPU_* are render passes timed on the GPU, see GpuTimer.
+enum class Zone : uint8_t { FRAME, EVENT, UPDATE, SHAPE, TEXT, SWAP, GPU_BACKGROUND, GPU_BUTTON, GPU_DIGIT, COUNT };
+
+const char *zone_name(Zone zone);
+
+struct ProfileSample {
+    uint64_t start = 0;  // ns, SDL_GetTicksNS
+    uint64_t end = 0;
+    uint32_t frame = 0;
+    Zone zone = Zone::FRAME;
+};
+
+// Ring of the most recent samples, the oldest is overwritten first.
+// Lock-free with a single writer: a slot is filled before head is published,
+// snapshot() drops anything the writer lapped while it was copying.
+struct Profiler {
+    static constexpr size_t CAPACITY = 8192;  // power of two, about a thousand frames
+
+    std::array<ProfileSample, CAPACITY> ring{};
+    std::atomic<uint64_t> head{0};  // samples ever written
+    uint32_t frame = 0;
+
+    void record(Zone zone, uint64_t start, uint64_t end) { record(zone, start, end, frame); }
+    void record(Zone zone, uint64_t start, uint64_t end, uint32_t sample_frame);  // for results that arrive late
+    void next_frame() { frame++; }
+
+    std::vector<ProfileSample> snapshot() const;  // oldest first
+
+    // Percentile (q in [0, 1]) of the per-frame total of zone, over the frames still in the ring
+    double percentile_ms(Zone zone, double q) const;
+
+    // CSV of the ring, one sample per line
+    bool dump(const char *path) const;
+
+    // p50/p99 of every zone with samples
+    void log_summary() const;
+};
+
+// Global profiler for the main thread
+Profiler &profiler();
+
+// Records the enclosing scope as one sample
+struct ScopedTimer {
+    Zone zone;
+    uint64_t start;
+
+    explicit ScopedTimer(Zone z);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
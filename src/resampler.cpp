@@ -0,0 +1,127 @@
+#include "resampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "audio_kernel.hpp"
+
+namespace {
+constexpr int HALF_TAPS = 16;          // sinc zero crossings each side when upsampling
+constexpr uint64_t MAX_PHASES = 1024;  // filter bank size cap for awkward ratios
+constexpr double KAISER_BETA = 8.0;    // about 80 dB stopband
+constexpr double PASSBAND = 0.9;       // cutoff as a fraction of the lower Nyquist
+
+struct FilterBank {
+    int half = 0;  // taps before the output position, the same after
+    int taps = 0;  // per phase
+    uint64_t phases = 0;
+    std::vector<float> coef;  // phases * taps
+};
+
+double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+FilterBank make_filter_bank(uint64_t up, uint64_t down) {
+    FilterBank fb;
+
+    // widen the filter when downsampling so the cutoff moves below the new Nyquist
+    const double ratio = std::min(1.0, static_cast<double>(up) / static_cast<double>(down));
+    const double cutoff = PASSBAND * ratio;  // relative to the source Nyquist
+
+    fb.half = static_cast<int>(std::ceil(HALF_TAPS / ratio));
+    fb.taps = fb.half * 2;
+    fb.phases = std::min(up, MAX_PHASES);
+    fb.coef.resize(static_cast<size_t>(fb.phases) * static_cast<size_t>(fb.taps));
+
+    const double norm = bessel_i0(KAISER_BETA);
+
+    for (uint64_t p = 0; p < fb.phases; p++) {
+        const double d = static_cast<double>(p) / static_cast<double>(fb.phases);
+        float *h = fb.coef.data() + p * static_cast<size_t>(fb.taps);
+        double sum = 0.0;
+
+        for (int k = 0; k < fb.taps; k++) {
+            // distance from the output position to source tap k, in source frames
+            const double x = (k - fb.half + 1) - d;
+            const double t = x / fb.half;
+            const double w = std::abs(t) < 1.0 ? bessel_i0(KAISER_BETA * std::sqrt(1.0 - t * t)) / norm : 0.0;
+            const double s = x == 0.0 ? 1.0 : std::sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            const double v = cutoff * s * w;
+
+            h[k] = static_cast<float>(v);
+            sum += v;
+        }
+
+        // unity gain at DC for every phase, otherwise phases beat against each other
+        for (int k = 0; k < fb.taps; k++) {
+            h[k] = static_cast<float>(h[k] / sum);
+        }
+    }
+
+    return fb;
+}
+
+}  // namespace
+
+std::vector<float> resample(const float *in, size_t frames, int channels, int src_rate, int dst_rate) {
+    const size_t ch = static_cast<size_t>(channels);
+
+    if (src_rate == dst_rate || frames == 0) {
+        return std::vector<float>(in, in + frames * ch);
+    }
+
+    const uint64_t g = std::gcd(static_cast<uint64_t>(src_rate), static_cast<uint64_t>(dst_rate));
+    const uint64_t up = static_cast<uint64_t>(dst_rate) / g;
+    const uint64_t down = static_cast<uint64_t>(src_rate) / g;
+    const FilterBank fb = make_filter_bank(up, down);
+
+    // zero pad both ends so the inner loop never bounds checks
+    const size_t pad = static_cast<size_t>(fb.half);
+    std::vector<float> src((frames + pad * 2) * ch, 0.0f);
+    std::copy(in, in + frames * ch, src.begin() + static_cast<std::ptrdiff_t>(pad * ch));
+
+    const size_t out_frames = static_cast<size_t>((frames * up + down - 1) / down);
+    std::vector<float> out(out_frames * ch);
+
+    for (size_t n = 0; n < out_frames; n++) {
+        const uint64_t pos = n * down;
+        const size_t i = static_cast<size_t>(pos / up);
+        const uint64_t phase = (pos % up) * fb.phases / up;
+
+        const float *h = fb.coef.data() + phase * static_cast<size_t>(fb.taps);
+        // tap 0 sits half - 1 frames before source frame i, shifted by the padding
+        const float *s = src.data() + (i + 1) * ch;
+
+        for (size_t c = 0; c < ch; c++) {
+            float acc = 0.0f;
+            for (int k = 0; k < fb.taps; k++) {
+                acc += h[k] * s[static_cast<size_t>(k) * ch + c];
+            }
+            out[n * ch + c] = acc;
+        }
+    }
+
+    return out;
+}
+
+std::vector<int16_t> resample(const int16_t *in, size_t frames, int channels, int src_rate, int dst_rate) {
+    const size_t n = frames * static_cast<size_t>(channels);
+
+    std::vector<float> f(n, 0.0f);
+    mix_s16(f.data(), in, n, 1.0f);
+
+    std::vector<float> r = resample(f.data(), frames, channels, src_rate, dst_rate);
+
+    std::vector<int16_t> out(r.size());
+    saturate_f32_to_s16(out.data(), r.data(), r.size());
+
+    return out;
+}
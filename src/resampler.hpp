@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Band limited sample rate conversion of a whole interleaved clip.
+// Polyphase windowed sinc, too slow for the audio thread, meant to run once at load.
+// Rational ratios get exact phases, awkward ones snap to the nearest of a fixed phase count.
+std::vector<float> resample(const float *in, size_t frames, int channels, int src_rate, int dst_rate);
+std::vector<int16_t> resample(const int16_t *in, size_t frames, int channels, int src_rate, int dst_rate);
@@ -404,6 +404,10 @@ enum STBVorbisError {
     VORBIS_ogg_skeleton_not_supported
 };
 
+#ifdef STB_VORBIS_TEST_HOOKS
+extern int stb_vorbis_test_imdct_overlap(int n, const float *spectrum, const float *previous, float *out);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -445,6 +449,16 @@ enum STBVorbisError {
 //      most platforms which requires endianness be defined correctly.
 // #define STB_VORBIS_NO_FAST_SCALED_FLOAT
 
+// STB_VORBIS_NO_SIMD
+//     use the scalar IMDCT butterflies and window overlap-add even when
+//     SSE2, NEON (aarch64) or WASM SIMD128 is available
+// #define STB_VORBIS_NO_SIMD
+
+// STB_VORBIS_TEST_HOOKS
+//     export stb_vorbis_test_imdct_overlap, which runs inverse_mdct and the
+//     overlap-add from vorbis_finish_frame on caller data without a stream
+// #define STB_VORBIS_TEST_HOOKS
+
 // STB_VORBIS_MAX_CHANNELS [number]
 //     globally define this to the maximum number of channels you need.
 //     The spec does not put a restriction on channels except that
@@ -482,6 +496,15 @@ enum STBVorbisError {
 #define STB_VORBIS_FAST_HUFFMAN_LENGTH 10
 #endif
 
+// STB_VORBIS_FAST_HUFFMAN_L2_LENGTH [number]
+//     codewords longer than STB_VORBIS_FAST_HUFFMAN_LENGTH but no longer than
+//     the sum of both lengths are found in a second-level table indexed by
+//     the next bits, one per first-level prefix that has such codewords.
+//     Set to 0 to go straight to the binary search instead.
+#ifndef STB_VORBIS_FAST_HUFFMAN_L2_LENGTH
+#define STB_VORBIS_FAST_HUFFMAN_L2_LENGTH 6
+#endif
+
 // STB_VORBIS_FAST_BINARY_LENGTH [number]
 //     sets the log size of the binary-search acceleration table. this
 //     is used in similar fashion to the fast-huffman size to set initial
@@ -637,6 +660,7 @@ typedef unsigned short uint16;
 typedef signed short int16;
 typedef unsigned int uint32;
 typedef signed int int32;
+typedef unsigned long long uint64;
 
 #ifndef TRUE
 #define TRUE 1
@@ -666,6 +690,11 @@ typedef float codetype;
 
 #define FAST_HUFFMAN_TABLE_SIZE (1 << STB_VORBIS_FAST_HUFFMAN_LENGTH)
 #define FAST_HUFFMAN_TABLE_MASK (FAST_HUFFMAN_TABLE_SIZE - 1)
+#define FAST_HUFFMAN_L2_SIZE (1 << STB_VORBIS_FAST_HUFFMAN_L2_LENGTH)
+#define FAST_HUFFMAN_L2_MASK (FAST_HUFFMAN_L2_SIZE - 1)
+
+// bits wanted in the accumulator before a table lookup
+#define FAST_HUFFMAN_PREP_BITS (STB_VORBIS_FAST_HUFFMAN_LENGTH + STB_VORBIS_FAST_HUFFMAN_L2_LENGTH)
 
 typedef struct {
     int dimensions, entries;
@@ -679,10 +708,13 @@ typedef struct {
     uint32 lookup_values;
     codetype *multiplicands;
     uint32 *codewords;
+    // first level: >= 0 is the symbol, -1 misses, -2 - k selects second-level table k
 #ifdef STB_VORBIS_FAST_HUFFMAN_SHORT
     int16 fast_huffman[FAST_HUFFMAN_TABLE_SIZE];
+    int16 *fast_huffman_l2;
 #else
     int32 fast_huffman[FAST_HUFFMAN_TABLE_SIZE];
+    int32 *fast_huffman_l2;
 #endif
     uint32 *sorted_codewords;
     int *sorted_values;
@@ -860,7 +892,7 @@ struct stb_vorbis {
     int next_seg;
     int last_seg;        // flag that we're on the last segment
     int last_seg_which;  // what was the segment number of the last seg?
-    uint32 acc;
+    uint64 acc;  // bit reservoir, up to 64 bits
     int valid_bits;
     int packet_bytes;
     int end_seg_with_known_loc;
@@ -1101,10 +1133,11 @@ static int compute_codewords(Codebook *c, uint8 *len, int n, uint32 *values) {
 }
 
 // accelerated huffman table allows fast O(1) match of all symbols
-// of length <= STB_VORBIS_FAST_HUFFMAN_LENGTH
-static void compute_accelerated_huffman(Codebook *c) {
-    int i, len;
+// of length <= STB_VORBIS_FAST_HUFFMAN_LENGTH + STB_VORBIS_FAST_HUFFMAN_L2_LENGTH
+static int compute_accelerated_huffman(vorb *f, Codebook *c) {
+    int i, len, l2_count = 0;
     for (i = 0; i < FAST_HUFFMAN_TABLE_SIZE; ++i) c->fast_huffman[i] = -1;
+    c->fast_huffman_l2 = NULL;
 
     len = c->sparse ? c->sorted_entries : c->entries;
 #ifdef STB_VORBIS_FAST_HUFFMAN_SHORT
@@ -1120,6 +1153,41 @@ static void compute_accelerated_huffman(Codebook *c) {
             }
         }
     }
+
+#if STB_VORBIS_FAST_HUFFMAN_L2_LENGTH > 0
+    // give every prefix of a longer codeword its own second-level table
+    for (i = 0; i < len; ++i) {
+        int l = c->codeword_lengths[i];
+        if (l > STB_VORBIS_FAST_HUFFMAN_LENGTH && l <= FAST_HUFFMAN_PREP_BITS && l != NO_CODE) {
+            uint32 z = c->sparse ? bit_reverse(c->sorted_codewords[i]) : c->codewords[i];
+            uint32 prefix = z & FAST_HUFFMAN_TABLE_MASK;
+            // a non-prefix-free codebook keeps the first level entry
+            if (c->fast_huffman[prefix] == -1) c->fast_huffman[prefix] = static_cast<int16>(-2 - l2_count++);
+        }
+    }
+
+    if (!l2_count) return TRUE;
+
+    c->fast_huffman_l2 = (decltype(c->fast_huffman_l2))setup_malloc(
+        f, static_cast<int>(sizeof(*c->fast_huffman_l2)) * (l2_count << STB_VORBIS_FAST_HUFFMAN_L2_LENGTH));
+    if (!c->fast_huffman_l2) return error(f, VORBIS_outofmem);
+    for (i = 0; i < (l2_count << STB_VORBIS_FAST_HUFFMAN_L2_LENGTH); ++i) c->fast_huffman_l2[i] = -1;
+
+    for (i = 0; i < len; ++i) {
+        int l = c->codeword_lengths[i];
+        if (l > STB_VORBIS_FAST_HUFFMAN_LENGTH && l <= FAST_HUFFMAN_PREP_BITS && l != NO_CODE) {
+            uint32 z = c->sparse ? bit_reverse(c->sorted_codewords[i]) : c->codewords[i];
+            int k = c->fast_huffman[z & FAST_HUFFMAN_TABLE_MASK];
+            if (k >= -1) continue;
+            auto *table = c->fast_huffman_l2 + ((-2 - k) << STB_VORBIS_FAST_HUFFMAN_L2_LENGTH);
+            uint32 step = 1u << (l - STB_VORBIS_FAST_HUFFMAN_LENGTH);
+            for (z >>= STB_VORBIS_FAST_HUFFMAN_LENGTH; z < FAST_HUFFMAN_L2_SIZE; z += step)
+                table[z] = static_cast<int16>(i);
+        }
+    }
+#endif
+    (void)f;
+    return TRUE;
 }
 
 #ifdef _MSC_VER
@@ -1549,12 +1617,7 @@ static uint32 get_bits(vorb *f, int n) {
 
     if (f->valid_bits < 0) return 0;
     if (f->valid_bits < n) {
-        if (n > 24) {
-            // the accumulator technique below would not work correctly in this case
-            z = get_bits(f, 24);
-            z += get_bits(f, n - 24) << 24;
-            return z;
-        }
+        // n <= 32 so the 64-bit reservoir never overflows here
         if (f->valid_bits == 0) f->acc = 0;
         while (f->valid_bits < n) {
             int z = get8_packet_raw(f);
@@ -1562,13 +1625,13 @@ static uint32 get_bits(vorb *f, int n) {
                 f->valid_bits = INVALID_BITS;
                 return 0;
             }
-            f->acc += static_cast<uint32>(z << f->valid_bits);
+            f->acc += (uint64)z << f->valid_bits;
             f->valid_bits += 8;
         }
     }
 
     assert(f->valid_bits >= n);
-    z = f->acc & ((1 << n) - 1);
+    z = static_cast<uint32>(f->acc & ((static_cast<uint64>(1) << n) - 1));
     f->acc >>= n;
     f->valid_bits -= n;
     return z;
@@ -1579,16 +1642,32 @@ static uint32 get_bits(vorb *f, int n) {
 // it might be nice to allow f->valid_bits and f->acc to be stored in registers,
 // e.g. cache them locally and decode locally
 static __forceinline void prep_huffman(vorb *f) {
-    if (f->valid_bits <= 24) {
+    if (f->valid_bits <= 56) {
         if (f->valid_bits == 0) f->acc = 0;
+
+        // fast path: the whole refill is inside the current segment in memory
+        if (USE_MEMORY(f)) {
+            int n = (64 - f->valid_bits) >> 3;
+            if (n <= f->bytes_in_seg && f->stream + n <= f->stream_end) {
+                for (int i = 0; i < n; ++i) {
+                    f->acc += (uint64)f->stream[i] << f->valid_bits;
+                    f->valid_bits += 8;
+                }
+                f->stream += n;
+                f->bytes_in_seg = static_cast<uint8>(f->bytes_in_seg - n);
+                f->packet_bytes += n;
+                return;
+            }
+        }
+
         do {
             int z;
             if (f->last_seg && !f->bytes_in_seg) return;
             z = get8_packet_raw(f);
             if (z == EOP) return;
-            f->acc += (unsigned)z << f->valid_bits;
+            f->acc += (uint64)z << f->valid_bits;
             f->valid_bits += 8;
-        } while (f->valid_bits <= 24);
+        } while (f->valid_bits <= 56);
     }
 }
 
@@ -1604,7 +1683,7 @@ static int codebook_decode_scalar_raw(vorb *f, Codebook *c) {
     //                             sorted_codewords && c->entries > 8
     if (c->entries > 8 ? c->sorted_codewords != NULL : !c->codewords) {
         // binary search
-        uint32 code = bit_reverse(f->acc);
+        uint32 code = bit_reverse(static_cast<uint32>(f->acc));
         int x = 0, n = c->sorted_entries, len;
 
         while (n > 1) {
@@ -1651,32 +1730,40 @@ static int codebook_decode_scalar_raw(vorb *f, Codebook *c) {
     return -1;
 }
 
+// both table levels, -1 when the codeword needs codebook_decode_scalar_raw
+static __forceinline int fast_huffman_lookup(vorb *f, Codebook *c) {
+    int i = c->fast_huffman[f->acc & FAST_HUFFMAN_TABLE_MASK];
+    if (i < -1) {
+        int next = static_cast<int>((f->acc >> STB_VORBIS_FAST_HUFFMAN_LENGTH) & FAST_HUFFMAN_L2_MASK);
+        i = c->fast_huffman_l2[((-2 - i) << STB_VORBIS_FAST_HUFFMAN_L2_LENGTH) | next];
+    }
+    return i;
+}
+
 #ifndef STB_VORBIS_NO_INLINE_DECODE
 
-#define DECODE_RAW(var, f, c)                                            \
-    if (f->valid_bits < STB_VORBIS_FAST_HUFFMAN_LENGTH) prep_huffman(f); \
-    var = f->acc & FAST_HUFFMAN_TABLE_MASK;                              \
-    var = c->fast_huffman[var];                                          \
-    if (var >= 0) {                                                      \
-        int n = c->codeword_lengths[var];                                \
-        f->acc >>= n;                                                    \
-        f->valid_bits -= n;                                              \
-        if (f->valid_bits < 0) {                                         \
-            f->valid_bits = 0;                                           \
-            var = -1;                                                    \
-        }                                                                \
-    } else {                                                             \
-        var = codebook_decode_scalar_raw(f, c);                          \
+#define DECODE_RAW(var, f, c)                                         \
+    if (f->valid_bits < FAST_HUFFMAN_PREP_BITS) prep_huffman(f);      \
+    var = fast_huffman_lookup(f, c);                                  \
+    if (var >= 0) {                                                   \
+        int n = c->codeword_lengths[var];                             \
+        f->acc >>= n;                                                 \
+        f->valid_bits -= n;                                           \
+        if (f->valid_bits < 0) {                                      \
+            f->valid_bits = 0;                                        \
+            var = -1;                                                 \
+        }                                                             \
+    } else {                                                          \
+        var = codebook_decode_scalar_raw(f, c);                       \
     }
 
 #else
 
 static int codebook_decode_scalar(vorb *f, Codebook *c) {
     int i;
-    if (f->valid_bits < STB_VORBIS_FAST_HUFFMAN_LENGTH) prep_huffman(f);
+    if (f->valid_bits < FAST_HUFFMAN_PREP_BITS) prep_huffman(f);
     // fast huffman table lookup
-    i = f->acc & FAST_HUFFMAN_TABLE_MASK;
-    i = c->fast_huffman[i];
+    i = fast_huffman_lookup(f, c);
     if (i >= 0) {
         f->acc >>= c->codeword_lengths[i];
         f->valid_bits -= c->codeword_lengths[i];
@@ -2342,6 +2429,85 @@ void inverse_mdct(float *buffer, int n, vorb *f, int blocktype) {
 }
 #endif
 
+// 4-wide float ops for the IMDCT step 3 butterflies and the window overlap-add.
+// Lane 0 is the lowest address. The vector code does the same multiplies and
+// adds in the same order as the scalar code, so the output is bit-exact
+// unless the compiler contracts the scalar code into FMAs.
+#ifndef STB_VORBIS_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STBV_SIMD
+typedef __m128 stbv_f4;
+static __forceinline stbv_f4 stbv_load(const float *p) { return _mm_loadu_ps(p); }
+static __forceinline void stbv_store(float *p, stbv_f4 v) { _mm_storeu_ps(p, v); }
+static __forceinline stbv_f4 stbv_add(stbv_f4 a, stbv_f4 b) { return _mm_add_ps(a, b); }
+static __forceinline stbv_f4 stbv_sub(stbv_f4 a, stbv_f4 b) { return _mm_sub_ps(a, b); }
+static __forceinline stbv_f4 stbv_mul(stbv_f4 a, stbv_f4 b) { return _mm_mul_ps(a, b); }
+static __forceinline stbv_f4 stbv_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static __forceinline stbv_f4 stbv_swap_pairs(stbv_f4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); }
+static __forceinline stbv_f4 stbv_reverse(stbv_f4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define STBV_SIMD
+typedef float32x4_t stbv_f4;
+static __forceinline stbv_f4 stbv_load(const float *p) { return vld1q_f32(p); }
+static __forceinline void stbv_store(float *p, stbv_f4 v) { vst1q_f32(p, v); }
+static __forceinline stbv_f4 stbv_add(stbv_f4 a, stbv_f4 b) { return vaddq_f32(a, b); }
+static __forceinline stbv_f4 stbv_sub(stbv_f4 a, stbv_f4 b) { return vsubq_f32(a, b); }
+static __forceinline stbv_f4 stbv_mul(stbv_f4 a, stbv_f4 b) { return vmulq_f32(a, b); }
+static __forceinline stbv_f4 stbv_set(float a, float b, float c, float d) {
+    float t[4] = {a, b, c, d};
+    return vld1q_f32(t);
+}
+static __forceinline stbv_f4 stbv_swap_pairs(stbv_f4 v) { return vrev64q_f32(v); }
+static __forceinline stbv_f4 stbv_reverse(stbv_f4 v) {
+    v = vrev64q_f32(v);
+    return vextq_f32(v, v, 2);
+}
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define STBV_SIMD
+typedef v128_t stbv_f4;
+static __forceinline stbv_f4 stbv_load(const float *p) { return wasm_v128_load(p); }
+static __forceinline void stbv_store(float *p, stbv_f4 v) { wasm_v128_store(p, v); }
+static __forceinline stbv_f4 stbv_add(stbv_f4 a, stbv_f4 b) { return wasm_f32x4_add(a, b); }
+static __forceinline stbv_f4 stbv_sub(stbv_f4 a, stbv_f4 b) { return wasm_f32x4_sub(a, b); }
+static __forceinline stbv_f4 stbv_mul(stbv_f4 a, stbv_f4 b) { return wasm_f32x4_mul(a, b); }
+static __forceinline stbv_f4 stbv_set(float a, float b, float c, float d) { return wasm_f32x4_make(a, b, c, d); }
+static __forceinline stbv_f4 stbv_swap_pairs(stbv_f4 v) { return wasm_i32x4_shuffle(v, v, 1, 0, 3, 2); }
+static __forceinline stbv_f4 stbv_reverse(stbv_f4 v) { return wasm_i32x4_shuffle(v, v, 3, 2, 1, 0); }
+#endif
+#endif  // STB_VORBIS_NO_SIMD
+
+#ifdef STBV_SIMD
+// Two step 3 butterflies on (even, odd) pairs, p points at the lowest of the 4 floats.
+// Pair 0 is p[3], p[2] and uses twiddle (c0, s0), pair 1 is p[1], p[0] with (c1, s1).
+//   e0 = e0 + e2
+//   e2 = (even * c - odd * s, odd * c + even * s) of e0 - e2
+static __forceinline void stbv_butterfly4(float *e0, float *e2, stbv_f4 c, stbv_f4 s) {
+    stbv_f4 a = stbv_load(e0);
+    stbv_f4 b = stbv_load(e2);
+    stbv_f4 d = stbv_sub(a, b);
+    stbv_store(e0, stbv_add(a, b));
+    stbv_store(e2, stbv_add(stbv_mul(d, c), stbv_mul(stbv_swap_pairs(d), s)));
+}
+
+static __forceinline stbv_f4 stbv_twiddle_c(const float *a0, const float *a1) {
+    return stbv_set(a1[0], a1[0], a0[0], a0[0]);
+}
+
+static __forceinline stbv_f4 stbv_twiddle_s(const float *a0, const float *a1) {
+    return stbv_set(a1[1], -a1[1], a0[1], -a0[1]);
+}
+
+// The 8 floats at e[0], e[-1] .. e[-7], pair k uses the twiddle at ak
+static __forceinline void stbv_butterfly8(
+    float *e0, float *e2, const float *a0, const float *a1, const float *a2, const float *a3) {
+    stbv_butterfly4(e0 - 3, e2 - 3, stbv_twiddle_c(a0, a1), stbv_twiddle_s(a0, a1));
+    stbv_butterfly4(e0 - 7, e2 - 7, stbv_twiddle_c(a2, a3), stbv_twiddle_s(a2, a3));
+}
+#endif
+
 // the following were split out into separate functions while optimizing;
 // they could be pushed back up but eh. __forceinline showed no change;
 // they're probably already being inlined.
@@ -2351,6 +2517,14 @@ static void imdct_step3_iter0_loop(int n, float *e, int i_off, int k_off, float
     int i;
 
     assert((n & 3) == 0);
+#ifdef STBV_SIMD
+    for (i = (n >> 2); i > 0; --i) {
+        stbv_butterfly8(ee0, ee2, A, A + 8, A + 16, A + 24);
+        A += 32;
+        ee0 -= 8;
+        ee2 -= 8;
+    }
+#else
     for (i = (n >> 2); i > 0; --i) {
         float k00_20, k01_21;
         k00_20 = ee0[0] - ee2[0];
@@ -2387,15 +2561,25 @@ static void imdct_step3_iter0_loop(int n, float *e, int i_off, int k_off, float
         ee0 -= 8;
         ee2 -= 8;
     }
+#endif
 }
 
 static void imdct_step3_inner_r_loop(int lim, float *e, int d0, int k_off, float *A, int k1) {
     int i;
-    float k00_20, k01_21;
 
     float *e0 = e + d0;
     float *e2 = e0 + k_off;
 
+#ifdef STBV_SIMD
+    for (i = lim >> 2; i > 0; --i) {
+        stbv_butterfly8(e0, e2, A, A + k1, A + k1 * 2, A + k1 * 3);
+        A += k1 * 4;
+        e0 -= 8;
+        e2 -= 8;
+    }
+#else
+    float k00_20, k01_21;
+
     for (i = lim >> 2; i > 0; --i) {
         k00_20 = e0[-0] - e2[-0];
         k01_21 = e0[-1] - e2[-1];
@@ -2436,6 +2620,7 @@ static void imdct_step3_inner_r_loop(int lim, float *e, int d0, int k_off, float
 
         A += k1;
     }
+#endif
 }
 
 static void imdct_step3_inner_s_loop(int n, float *e, int i_off, int k_off, float *A, int a_off, int k0) {
@@ -2449,11 +2634,24 @@ static void imdct_step3_inner_s_loop(int n, float *e, int i_off, int k_off, floa
     float A6 = A[0 + a_off * 3 + 0];
     float A7 = A[0 + a_off * 3 + 1];
 
-    float k00, k11;
-
     float *ee0 = e + i_off;
     float *ee2 = ee0 + k_off;
 
+#ifdef STBV_SIMD
+    // the twiddles are the same for every iteration
+    float a01[2] = {A0, A1}, a23[2] = {A2, A3}, a45[2] = {A4, A5}, a67[2] = {A6, A7};
+    stbv_f4 c_hi = stbv_twiddle_c(a01, a23), s_hi = stbv_twiddle_s(a01, a23);
+    stbv_f4 c_lo = stbv_twiddle_c(a45, a67), s_lo = stbv_twiddle_s(a45, a67);
+
+    for (i = n; i > 0; --i) {
+        stbv_butterfly4(ee0 - 3, ee2 - 3, c_hi, s_hi);
+        stbv_butterfly4(ee0 - 7, ee2 - 7, c_lo, s_lo);
+        ee0 -= k0;
+        ee2 -= k0;
+    }
+#else
+    float k00, k11;
+
     for (i = n; i > 0; --i) {
         k00 = ee0[0] - ee2[0];
         k11 = ee0[-1] - ee2[-1];
@@ -2486,6 +2684,7 @@ static void imdct_step3_inner_s_loop(int n, float *e, int i_off, int k_off, floa
         ee0 -= k0;
         ee2 -= k0;
     }
+#endif
 }
 
 static __forceinline void iter_54(float *z) {
@@ -3393,7 +3592,17 @@ static int vorbis_finish_frame(stb_vorbis *f, int len, int left, int right) {
         float *w = get_window(f, n);
         if (w == NULL) return 0;
         for (i = 0; i < f->channels; ++i) {
-            for (j = 0; j < n; ++j)
+            j = 0;
+#ifdef STBV_SIMD
+            for (; j + 4 <= n; j += 4) {
+                float *out = f->channel_buffers[i] + left + j;
+                stbv_f4 rw = stbv_reverse(stbv_load(w + n - 4 - j));
+                stbv_store(out,
+                           stbv_add(stbv_mul(stbv_load(out), stbv_load(w + j)),
+                                    stbv_mul(stbv_load(f->previous_window[i] + j), rw)));
+            }
+#endif
+            for (; j < n; ++j)
                 f->channel_buffers[i][left + j] =
                     f->channel_buffers[i][left + j] * w[j] + f->previous_window[i][j] * w[n - 1 - j];
         }
@@ -3754,7 +3963,7 @@ static int start_decoder(vorb *f) {
             c->codewords = NULL;
         }
 
-        compute_accelerated_huffman(c);
+        if (!compute_accelerated_huffman(f, c)) return FALSE;
 
         CHECK(f);
         c->lookup_type = static_cast<uint8>(get_bits(f, 4));
@@ -4146,6 +4355,7 @@ static void vorbis_deinit(stb_vorbis *p) {
             setup_free(p, c->multiplicands);
             setup_free(p, c->codewords);
             setup_free(p, c->sorted_codewords);
+            setup_free(p, c->fast_huffman_l2);
             // c->sorted_values[-1] is the first entry in the array
             setup_free(p, c->sorted_values ? c->sorted_values - 1 : NULL);
         }
@@ -5310,6 +5520,38 @@ int stb_vorbis_get_samples_float(stb_vorbis *f, int channels, float **buffer, in
 }
 #endif  // STB_VORBIS_NO_PULLDATA_API
 
+#ifdef STB_VORBIS_TEST_HOOKS
+int stb_vorbis_test_imdct_overlap(int n, const float *spectrum, const float *previous, float *out) {
+    int n2 = n >> 1;
+    stb_vorbis *f = (stb_vorbis *)malloc(sizeof(*f));
+    if (f == NULL) return 0;
+    vorbis_init(f, NULL);
+
+    // one mono stream where both block sizes are n
+    f->blocksize_0 = f->blocksize_1 = n;
+    f->channels = 1;
+    f->channel_buffers[0] = (float *)setup_malloc(f, static_cast<int>(sizeof(float)) * n);
+    f->previous_window[0] = (float *)setup_malloc(f, static_cast<int>(sizeof(float)) * n2);
+
+    if (!f->channel_buffers[0] || !f->previous_window[0] || !init_blocksize(f, 0, n)) {
+        stb_vorbis_close(f);
+        return 0;
+    }
+
+    memcpy(f->channel_buffers[0], spectrum, sizeof(float) * static_cast<size_t>(n2));
+    memcpy(f->previous_window[0], previous, sizeof(float) * static_cast<size_t>(n2));
+    f->previous_length = n2;
+
+    inverse_mdct(f->channel_buffers[0], n, f, 0);
+    vorbis_finish_frame(f, n, 0, n2);
+
+    memcpy(out, f->channel_buffers[0], sizeof(float) * static_cast<size_t>(n));
+    stb_vorbis_close(f);
+
+    return 1;
+}
+#endif  // STB_VORBIS_TEST_HOOKS
+
 /* Version history
     1.17    - 2019-07-08 - fix CVE-2019-13217, -13218, -13219, -13220, -13221, -13222, -13223
                            found with Mayhem by ForAllSecure
@@ -3,5 +3,39 @@
 typedef unsigned char uint8;
 
 extern "C" {
+typedef struct {
+    char *alloc_buffer;
+    int alloc_buffer_length_in_bytes;
+} stb_vorbis_alloc;
+
+typedef struct stb_vorbis stb_vorbis;
+
+typedef struct {
+    unsigned int sample_rate;
+    int channels;
+
+    unsigned int setup_memory_required;
+    unsigned int setup_temp_memory_required;
+    unsigned int temp_memory_required;
+
+    int max_frame_size;
+} stb_vorbis_info;
+
 int stb_vorbis_decode_memory(const uint8 *mem, int len, int *channels, int *sample_rate, short **output);
+
+// pull API, data must outlive the decoder
+stb_vorbis *stb_vorbis_open_memory(const uint8 *data, int len, int *error, const stb_vorbis_alloc *alloc_buffer);
+stb_vorbis_info stb_vorbis_get_info(stb_vorbis *f);
+int stb_vorbis_get_samples_short_interleaved(stb_vorbis *f, int channels, short *buffer, int num_shorts);
+int stb_vorbis_get_samples_float_interleaved(stb_vorbis *f, int channels, float *buffer, int num_floats);
+int stb_vorbis_seek(stb_vorbis *f, unsigned int sample_number);
+int stb_vorbis_seek_start(stb_vorbis *f);
+unsigned int stb_vorbis_stream_length_in_samples(stb_vorbis *f);
+void stb_vorbis_close(stb_vorbis *f);
+
+#ifdef STB_VORBIS_TEST_HOOKS
+// inverse_mdct of n/2 spectral values, then overlap-add of previous (n/2 samples) into the first half.
+// out receives all n samples. Returns 0 on allocation failure.
+int stb_vorbis_test_imdct_overlap(int n, const float *spectrum, const float *previous, float *out);
+#endif
 }